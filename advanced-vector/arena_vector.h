@@ -0,0 +1,189 @@
+#pragma once
+#include "vector.h"
+
+#include <cassert>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+// Монотонная арена: память выделяется сдвигом указателя внутри крупных блоков и освобождается
+// целиком в Release() или деструкторе. Последнее выделение можно расширить на месте
+// или вернуть арене, остальные освобождения ничего не делают.
+class Arena {
+	struct Chunk {
+		Chunk* prev;
+		size_t bytes;
+	};
+
+	static constexpr size_t HEADER_BYTES = (sizeof(Chunk) + alignof(std::max_align_t) - 1)
+		/ alignof(std::max_align_t) * alignof(std::max_align_t);
+
+public:
+	static constexpr size_t DEFAULT_CHUNK_BYTES = 64 << 10;
+
+	explicit Arena(size_t chunk_bytes = DEFAULT_CHUNK_BYTES) noexcept
+		: next_chunk_bytes_(std::max(chunk_bytes, HEADER_BYTES * 2)) {
+	}
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	~Arena() {
+		Release();
+	}
+
+	void* Allocate(size_t bytes, size_t align) {
+		assert(align != 0 && (align & (align - 1)) == 0);
+		// Выравнивание сравнивается с остатком куска до сдвига указателя:
+		// выровненный адрес может оказаться за концом куска
+		size_t padding = Padding(cursor_, align);
+		if (cursor_ == nullptr || !Fits(padding, bytes)) {
+			AddChunk(bytes, align);
+			padding = Padding(cursor_, align);
+		}
+		unsigned char* result = cursor_ + padding;
+		cursor_ = result + bytes;
+		allocated_bytes_ += bytes;
+		return result;
+	}
+
+	// Расширяет блок до new_bytes, если он выделен последним и в текущем куске хватает места
+	bool TryExtend(void* p, size_t old_bytes, size_t new_bytes) noexcept {
+		unsigned char* block = static_cast<unsigned char*>(p);
+		if (block + old_bytes != cursor_ || new_bytes < old_bytes
+			|| static_cast<size_t>(limit_ - block) < new_bytes) {
+			return false;
+		}
+		cursor_ = block + new_bytes;
+		allocated_bytes_ += new_bytes - old_bytes;
+		return true;
+	}
+
+	// Память возвращается арене только для последнего выделения
+	void Deallocate(void* p, size_t bytes) noexcept {
+		unsigned char* block = static_cast<unsigned char*>(p);
+		if (block + bytes == cursor_) {
+			cursor_ = block;
+			allocated_bytes_ -= bytes;
+		}
+	}
+
+	// Освобождает все куски. Указатели на выделенную ареной память становятся недействительными.
+	void Release() noexcept {
+		while (head_ != nullptr) {
+			Chunk* prev = head_->prev;
+			::operator delete(static_cast<void*>(head_), head_->bytes);
+			head_ = prev;
+		}
+		cursor_ = nullptr;
+		limit_ = nullptr;
+		allocated_bytes_ = 0;
+		reserved_bytes_ = 0;
+	}
+
+	// Байты, выданные пользователям арены
+	size_t AllocatedBytes() const noexcept {
+		return allocated_bytes_;
+	}
+
+	// Байты, полученные ареной из кучи
+	size_t ReservedBytes() const noexcept {
+		return reserved_bytes_;
+	}
+
+private:
+	static size_t Padding(const unsigned char* p, size_t align) noexcept {
+		const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(p);
+		return (align - address % align) % align;
+	}
+
+	bool Fits(size_t padding, size_t bytes) const noexcept {
+		const size_t space = static_cast<size_t>(limit_ - cursor_);
+		return padding <= space && bytes <= space - padding;
+	}
+
+	// Размер кусков растёт геометрически, чтобы число обращений к куче было логарифмическим
+	void AddChunk(size_t bytes, size_t align) {
+		const size_t needed = HEADER_BYTES + bytes + align;
+		if (needed < bytes) {
+			throw std::bad_alloc();
+		}
+		const size_t chunk_bytes = std::max(next_chunk_bytes_, needed);
+		Chunk* chunk = static_cast<Chunk*>(::operator new(chunk_bytes));
+		chunk->prev = head_;
+		chunk->bytes = chunk_bytes;
+		head_ = chunk;
+		cursor_ = reinterpret_cast<unsigned char*>(chunk) + HEADER_BYTES;
+		limit_ = reinterpret_cast<unsigned char*>(chunk) + chunk_bytes;
+		reserved_bytes_ += chunk_bytes;
+		if (next_chunk_bytes_ <= std::numeric_limits<size_t>::max() / 2) {
+			next_chunk_bytes_ *= 2;
+		}
+	}
+
+	Chunk* head_ = nullptr;
+	unsigned char* cursor_ = nullptr;
+	unsigned char* limit_ = nullptr;
+	size_t next_chunk_bytes_;
+	size_t allocated_bytes_ = 0;
+	size_t reserved_bytes_ = 0;
+};
+
+// Аллокатор, выделяющий память из арены. Рост последнего выделенного буфера выполняется
+// на месте через try_expand. Аллокаторы равны, если ссылаются на одну арену: перемещение
+// и Swap векторов одной арены передают буферы без копирования элементов.
+template <typename T>
+class ArenaAllocator {
+public:
+	using value_type = T;
+
+	ArenaAllocator(Arena& arena) noexcept
+		: arena_(&arena) {
+	}
+
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+		: arena_(&other.GetArena()) {
+	}
+
+	T* allocate(size_t n) {
+		return static_cast<T*>(arena_->Allocate(ByteSize(n), alignof(T)));
+	}
+
+	void deallocate(T* p, size_t n) noexcept {
+		arena_->Deallocate(p, n * sizeof(T));
+	}
+
+	bool try_expand(T* p, size_t old_n, size_t new_n) noexcept {
+		return new_n <= std::numeric_limits<size_t>::max() / sizeof(T)
+			&& arena_->TryExtend(p, old_n * sizeof(T), new_n * sizeof(T));
+	}
+
+	Arena& GetArena() const noexcept {
+		return *arena_;
+	}
+
+	template <typename U>
+	bool operator==(const ArenaAllocator<U>& other) const noexcept {
+		return arena_ == &other.GetArena();
+	}
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const noexcept {
+		return !(*this == other);
+	}
+
+private:
+	static size_t ByteSize(size_t n) {
+		if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+			throw std::bad_alloc();
+		}
+		return n * sizeof(T);
+	}
+
+	Arena* arena_;
+};
+
+// Вектор во временной памяти запроса. Для тривиально разрушаемых T деструктор
+// не делает ничего, память освобождается вместе с ареной.
+template <typename T, typename Growth = DoublingGrowth>
+using ArenaVector = Vector<T, ArenaAllocator<T>, Growth>;
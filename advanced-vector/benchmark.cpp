@@ -0,0 +1,504 @@
+// Сравнение производительности Vector и std::vector.
+// Сборка: g++ -std=c++17 -O2 -DNDEBUG benchmark.cpp -lbenchmark -lpthread -o benchmark
+// Результаты в машиночитаемом виде: ./benchmark --benchmark_format=json --benchmark_out=result.json
+
+#include "vector.h"
+#include "chunked_vector.h"
+#include "flat_map.h"
+#include "incremental_vector.h"
+#include "parallel_algorithms.h"
+#include "soa_vector.h"
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <chrono>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct Pod64 {
+        int values[16];
+    };
+
+    // Копирование может выбросить исключение, а перемещение не объявлено noexcept,
+    // поэтому при реаллокации элементы копируются
+    struct ThrowingCopy {
+        ThrowingCopy() = default;
+        explicit ThrowingCopy(int id)
+            : id(id) {
+        }
+        ThrowingCopy(const ThrowingCopy& other)
+            : id(other.id)
+            , name(other.name) {
+            if (other.throw_on_copy) {
+                throw std::runtime_error("Oops");
+            }
+        }
+        ThrowingCopy(ThrowingCopy&& other)
+            : id(other.id)
+            , name(std::move(other.name)) {
+        }
+        ThrowingCopy& operator=(const ThrowingCopy& other) = default;
+        ThrowingCopy& operator=(ThrowingCopy&& other) = default;
+
+        bool throw_on_copy = false;
+        int id = 0;
+        std::string name;
+    };
+
+    // Тяжёлый элемент, считающий копирования и перемещения (включая присваивания)
+    struct Heavy {
+        Heavy() = default;
+        explicit Heavy(int id)
+            : id(id) {
+        }
+        Heavy(const Heavy& other)
+            : id(other.id)
+            , payload(other.payload) {
+            ++copies;
+        }
+        Heavy(Heavy&& other) noexcept
+            : id(other.id)
+            , payload(std::move(other.payload)) {
+            ++moves;
+        }
+        Heavy& operator=(const Heavy& other) {
+            id = other.id;
+            payload = other.payload;
+            ++copies;
+            return *this;
+        }
+        Heavy& operator=(Heavy&& other) noexcept {
+            id = other.id;
+            payload = std::move(other.payload);
+            ++moves;
+            return *this;
+        }
+
+        int id = 0;
+        std::string payload = std::string(64, 'x');
+
+        static inline long long copies = 0;
+        static inline long long moves = 0;
+    };
+
+    template <typename T>
+    T MakeValue(int i);
+
+    template <>
+    int MakeValue<int>(int i) {
+        return i;
+    }
+
+    template <>
+    Pod64 MakeValue<Pod64>(int i) {
+        Pod64 pod{};
+        pod.values[0] = i;
+        return pod;
+    }
+
+    template <>
+    std::string MakeValue<std::string>(int i) {
+        // Длиннее буфера SSO, чтобы строка владела памятью в куче
+        return std::string(32, static_cast<char>('a' + i % 26));
+    }
+
+    template <>
+    ThrowingCopy MakeValue<ThrowingCopy>(int i) {
+        return ThrowingCopy(i);
+    }
+
+    template <>
+    Heavy MakeValue<Heavy>(int i) {
+        return Heavy(i);
+    }
+
+    int Id(int value) {
+        return value;
+    }
+    int Id(const Pod64& value) {
+        return value.values[0];
+    }
+    int Id(const std::string& value) {
+        return value[0];
+    }
+    int Id(const ThrowingCopy& value) {
+        return value.id;
+    }
+
+    // Единый интерфейс для std::vector и Vector
+    template <typename T>
+    void Append(std::vector<T>& v, T value) {
+        v.push_back(std::move(value));
+    }
+    template <typename T>
+    void Append(Vector<T>& v, T value) {
+        v.PushBack(std::move(value));
+    }
+    template <typename T, size_t ChunkBytes>
+    void Append(ChunkedVector<T, ChunkBytes>& v, T value) {
+        v.PushBack(std::move(value));
+    }
+    template <typename T>
+    void Append(IncrementalVector<T>& v, T value) {
+        v.PushBack(std::move(value));
+    }
+
+    template <typename T>
+    void ReserveFor(std::vector<T>& v, size_t capacity) {
+        v.reserve(capacity);
+    }
+    template <typename T>
+    void ReserveFor(Vector<T>& v, size_t capacity) {
+        v.Reserve(capacity);
+    }
+
+    template <typename T>
+    void InsertAt(std::vector<T>& v, size_t index, const T& value) {
+        v.insert(v.begin() + index, value);
+    }
+    template <typename T>
+    void InsertAt(Vector<T>& v, size_t index, const T& value) {
+        v.Insert(v.cbegin() + index, value);
+    }
+
+    template <typename T>
+    void EraseAt(std::vector<T>& v, size_t index) {
+        v.erase(v.begin() + index);
+    }
+    template <typename T>
+    void EraseAt(Vector<T>& v, size_t index) {
+        v.Erase(v.cbegin() + index);
+    }
+
+    template <typename Container>
+    using ValueType = typename std::iterator_traits<decltype(std::declval<Container&>().begin())>::value_type;
+
+    template <typename Container>
+    Container MakeFilled(size_t size) {
+        using T = ValueType<Container>;
+        Container v;
+        ReserveFor(v, size);
+        for (size_t i = 0; i < size; ++i) {
+            Append(v, MakeValue<T>(static_cast<int>(i)));
+        }
+        return v;
+    }
+
+}  // namespace
+
+// Рост с нуля без Reserve
+template <typename Container>
+void BM_PushBack(benchmark::State& state) {
+    using T = ValueType<Container>;
+    const size_t size = state.range(0);
+    const T value = MakeValue<T>(1);
+    for (auto _ : state) {
+        Container v;
+        for (size_t i = 0; i < size; ++i) {
+            Append(v, value);
+        }
+        benchmark::DoNotOptimize(&*v.begin());
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+template <typename Container>
+void BM_ReservePushBack(benchmark::State& state) {
+    using T = ValueType<Container>;
+    const size_t size = state.range(0);
+    const T value = MakeValue<T>(1);
+    for (auto _ : state) {
+        Container v;
+        ReserveFor(v, size);
+        for (size_t i = 0; i < size; ++i) {
+            Append(v, value);
+        }
+        benchmark::DoNotOptimize(&*v.begin());
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+// Приёмник уже вмещает источник: элементы присваиваются без реаллокации
+template <typename Container>
+void BM_CopyAssignFits(benchmark::State& state) {
+    const size_t size = state.range(0);
+    const Container src = MakeFilled<Container>(size);
+    Container dst = MakeFilled<Container>(size);
+    for (auto _ : state) {
+        dst = src;
+        benchmark::DoNotOptimize(&*dst.begin());
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+// Приёмник пуст: каждое присваивание выделяет новый буфер
+template <typename Container>
+void BM_CopyAssignRealloc(benchmark::State& state) {
+    const size_t size = state.range(0);
+    const Container src = MakeFilled<Container>(size);
+    for (auto _ : state) {
+        Container dst;
+        dst = src;
+        benchmark::DoNotOptimize(&*dst.begin());
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+template <typename Container>
+void BM_MidInsertErase(benchmark::State& state) {
+    using T = ValueType<Container>;
+    const size_t size = state.range(0);
+    Container v = MakeFilled<Container>(size);
+    ReserveFor(v, size + 1);
+    const T value = MakeValue<T>(1);
+    for (auto _ : state) {
+        InsertAt(v, size / 2, value);
+        EraseAt(v, size / 2);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Копирования и перемещения элементов на одну пару вставка + удаление в середине
+template <typename Container>
+void BM_MidInsertCounts(benchmark::State& state) {
+    const size_t size = state.range(0);
+    Container v = MakeFilled<Container>(size);
+    ReserveFor(v, size + 1);
+    const Heavy value(1);
+    Heavy::copies = 0;
+    Heavy::moves = 0;
+    for (auto _ : state) {
+        InsertAt(v, size / 2, value);
+        EraseAt(v, size / 2);
+    }
+    state.counters["copies"] = benchmark::Counter(static_cast<double>(Heavy::copies), benchmark::Counter::kAvgIterations);
+    state.counters["moves"] = benchmark::Counter(static_cast<double>(Heavy::moves), benchmark::Counter::kAvgIterations);
+}
+
+template <typename Container>
+void BM_Iterate(benchmark::State& state) {
+    const size_t size = state.range(0);
+    const Container v = MakeFilled<Container>(size);
+    for (auto _ : state) {
+        long long sum = 0;
+        for (const auto& value : v) {
+            sum += Id(value);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+    state.SetBytesProcessed(state.iterations() * size * sizeof(ValueType<Container>));
+}
+
+// Заполнение нулями против инициализации по умолчанию
+void BM_ResizeValueInit(benchmark::State& state) {
+    const size_t size = state.range(0);
+    for (auto _ : state) {
+        Vector<char> v;
+        v.Resize(size);
+        benchmark::DoNotOptimize(&*v.begin());
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+
+void BM_ResizeDefaultInit(benchmark::State& state) {
+    const size_t size = state.range(0);
+    for (auto _ : state) {
+        Vector<char> v;
+        v.ResizeDefaultInit(size);
+        benchmark::DoNotOptimize(&*v.begin());
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+
+// Копирование большого вектора строк в одном и в нескольких потоках
+void BM_CopyStrings(benchmark::State& state) {
+    const Vector<std::string> src = MakeFilled<Vector<std::string>>(state.range(0));
+    for (auto _ : state) {
+        Vector<std::string> dst(src);
+        benchmark::DoNotOptimize(&*dst.begin());
+    }
+    state.SetItemsProcessed(state.iterations() * src.Size());
+}
+
+void BM_CopyStringsParallel(benchmark::State& state) {
+    const Vector<std::string> src = MakeFilled<Vector<std::string>>(state.range(0));
+    for (auto _ : state) {
+        Vector<std::string> dst(PARALLEL, src);
+        benchmark::DoNotOptimize(&*dst.begin());
+    }
+    state.SetItemsProcessed(state.iterations() * src.Size());
+}
+
+// Короткоживущие векторы одного размера: с кэшем буферов потока и без него
+template <typename Container>
+void BM_ShortLived(benchmark::State& state) {
+    const size_t size = state.range(0);
+    for (auto _ : state) {
+        Container v;
+        for (size_t i = 0; i < size; ++i) {
+            v.PushBack(static_cast<int>(i));
+        }
+        benchmark::DoNotOptimize(&*v.begin());
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+// Сумма одного поля записей: в SoAVector читается только его столбец
+struct Record {
+    int id;
+    double price;
+    char payload[48];
+};
+
+void BM_SumFieldAoS(benchmark::State& state) {
+    const size_t size = state.range(0);
+    Vector<Record> v;
+    for (size_t i = 0; i < size; ++i) {
+        v.PushBack(Record{ static_cast<int>(i), i * 0.5, {} });
+    }
+    for (auto _ : state) {
+        double sum = 0;
+        for (const Record& r : v) {
+            sum += r.price;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+void BM_SumFieldSoA(benchmark::State& state) {
+    const size_t size = state.range(0);
+    SoAVector<int, double, std::array<char, 48>> v;
+    for (size_t i = 0; i < size; ++i) {
+        v.EmplaceBack(static_cast<int>(i), i * 0.5, std::array<char, 48>{});
+    }
+    for (auto _ : state) {
+        double sum = 0;
+        for (double price : v.Column<1>()) {
+            sum += price;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+// Поиск случайных ключей в словаре из state.range(0) элементов
+template <typename Map>
+void BM_MapFind(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    Map map;
+    for (int i = 0; i < size; ++i) {
+        map[i * 2] = i;
+    }
+    constexpr bool IS_STD_MAP = std::is_same_v<Map, std::map<int, int>>;
+    if constexpr (!IS_STD_MAP) {
+        if (state.range(1) != 0) {
+            map.BuildSearchIndex();
+        }
+    }
+    unsigned key = 1;
+    for (auto _ : state) {
+        key = key * 1664525u + 1013904223u;
+        const int k = static_cast<int>(key % (size * 2));
+        if constexpr (IS_STD_MAP) {
+            benchmark::DoNotOptimize(map.find(k));
+        }
+        else {
+            benchmark::DoNotOptimize(map.Find(k));
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Сортировка случайных чисел: std::sort и параллельная сортировка слиянием на общем пуле
+template <bool Parallel>
+void BM_Sort(benchmark::State& state) {
+    const size_t size = state.range(0);
+    Vector<unsigned> source(size);
+    unsigned seed = 1;
+    for (unsigned& x : source) {
+        seed = seed * 1664525u + 1013904223u;
+        x = seed;
+    }
+    Vector<unsigned> v(size);
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::copy(source.begin(), source.end(), v.begin());
+        state.ResumeTiming();
+        if constexpr (Parallel) {
+            ParallelSort(v.begin(), v.end());
+        }
+        else {
+            std::sort(v.begin(), v.end());
+        }
+        benchmark::DoNotOptimize(v.begin());
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+// Самое долгое добавление: у Vector оно включает перенос всех элементов
+template <typename Container>
+void BM_PushBackMaxLatency(benchmark::State& state) {
+    const size_t size = state.range(0);
+    double max_ns = 0;
+    for (auto _ : state) {
+        Container v;
+        for (size_t i = 0; i < size; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            Append(v, static_cast<int>(i));
+            const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            max_ns = std::max(max_ns, elapsed.count());
+        }
+        benchmark::DoNotOptimize(&*v.begin());
+    }
+    state.counters["max_push_ns"] = max_ns;
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+#define VECTOR_BENCHMARK(Benchmark, Elem, MaxSize)                                          \
+    BENCHMARK_TEMPLATE(Benchmark, std::vector<Elem>)->RangeMultiplier(16)->Range(16, MaxSize); \
+    BENCHMARK_TEMPLATE(Benchmark, Vector<Elem>)->RangeMultiplier(16)->Range(16, MaxSize)
+
+#define VECTOR_BENCHMARKS(Elem)                           \
+    VECTOR_BENCHMARK(BM_PushBack, Elem, 1 << 16);         \
+    VECTOR_BENCHMARK(BM_ReservePushBack, Elem, 1 << 16);  \
+    VECTOR_BENCHMARK(BM_CopyAssignFits, Elem, 1 << 16);   \
+    VECTOR_BENCHMARK(BM_CopyAssignRealloc, Elem, 1 << 16); \
+    VECTOR_BENCHMARK(BM_MidInsertErase, Elem, 1 << 16);   \
+    VECTOR_BENCHMARK(BM_Iterate, Elem, 1 << 16)
+
+VECTOR_BENCHMARKS(int);
+VECTOR_BENCHMARKS(Pod64);
+VECTOR_BENCHMARKS(std::string);
+VECTOR_BENCHMARKS(ThrowingCopy);
+
+VECTOR_BENCHMARK(BM_MidInsertCounts, Heavy, 1 << 10);
+
+BENCHMARK_TEMPLATE(BM_ShortLived, Vector<int>)->Arg(16)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_ShortLived, RecyclingVector<int>)->Arg(16)->Arg(1024);
+
+BENCHMARK_TEMPLATE(BM_PushBackMaxLatency, Vector<int>)->Arg(1 << 24);
+BENCHMARK_TEMPLATE(BM_PushBackMaxLatency, ChunkedVector<int>)->Arg(1 << 24);
+BENCHMARK_TEMPLATE(BM_PushBackMaxLatency, IncrementalVector<int>)->Arg(1 << 24);
+
+BENCHMARK_TEMPLATE(BM_MapFind, std::map<int, int>)->Args({ 1 << 20, 0 });
+BENCHMARK_TEMPLATE(BM_MapFind, FlatMap<int, int>)->Args({ 1 << 20, 0 })->Args({ 1 << 20, 1 });
+
+BENCHMARK_TEMPLATE(BM_Sort, false)->Arg(1 << 22)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Sort, true)->Arg(1 << 22)->UseRealTime();
+
+BENCHMARK(BM_SumFieldAoS)->Arg(1 << 20);
+BENCHMARK(BM_SumFieldSoA)->Arg(1 << 20);
+
+BENCHMARK(BM_ResizeValueInit)->Arg(64 << 20);
+BENCHMARK(BM_ResizeDefaultInit)->Arg(64 << 20);
+BENCHMARK(BM_CopyStrings)->Arg(1 << 22)->UseRealTime();
+BENCHMARK(BM_CopyStringsParallel)->Arg(1 << 22)->UseRealTime();
+
+BENCHMARK_MAIN();
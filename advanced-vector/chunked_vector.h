@@ -0,0 +1,345 @@
+#pragma once
+#include "vector.h"
+
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+// Вектор из блоков RawMemory фиксированного размера и индекса блоков. Добавление элемента
+// никогда не переносит элементы: при заполнении выделяется новый блок, а в индекс дописывается
+// только его дескриптор, поэтому адреса элементов стабильны. Индекс — обычный Vector и изредка
+// реаллоцируется, перенося дескрипторы всех блоков (в CHUNK_SIZE раз меньше, чем элементов),
+// так что задержка EmplaceBack постоянна лишь амортизированно. Flatten() собирает элементы
+// в непрерывный Vector<T>.
+template <typename T, size_t ChunkBytes = PAGE_BYTES * 4>
+class ChunkedVector {
+public:
+	// Число элементов в блоке — степень двойки, чтобы индекс делился сдвигом
+	static constexpr size_t CHUNK_SHIFT = detail::FloorLog2(std::max<size_t>(ChunkBytes / sizeof(T), 1));
+	static constexpr size_t CHUNK_SIZE = size_t{ 1 } << CHUNK_SHIFT;
+
+	template <bool Const>
+	class Iterator {
+		using Chunk = std::conditional_t<Const, const RawMemory<T>, RawMemory<T>>;
+
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using reference = std::conditional_t<Const, const T&, T&>;
+		using pointer = std::conditional_t<Const, const T*, T*>;
+
+		Iterator() = default;
+
+		Iterator(Chunk* chunks, size_t index) noexcept
+			: chunks_(chunks)
+			, index_(index) {
+		}
+
+		operator Iterator<true>() const noexcept {
+			return Iterator<true>(chunks_, index_);
+		}
+
+		reference operator*() const noexcept {
+			return chunks_[index_ >> CHUNK_SHIFT][index_ & (CHUNK_SIZE - 1)];
+		}
+		pointer operator->() const noexcept {
+			return &**this;
+		}
+		reference operator[](difference_type n) const noexcept {
+			return *(*this + n);
+		}
+		Iterator& operator++() noexcept {
+			++index_;
+			return *this;
+		}
+		Iterator operator++(int) noexcept {
+			Iterator old = *this;
+			++index_;
+			return old;
+		}
+		Iterator& operator--() noexcept {
+			--index_;
+			return *this;
+		}
+		Iterator operator--(int) noexcept {
+			Iterator old = *this;
+			--index_;
+			return old;
+		}
+		Iterator& operator+=(difference_type n) noexcept {
+			index_ += n;
+			return *this;
+		}
+		Iterator& operator-=(difference_type n) noexcept {
+			index_ -= n;
+			return *this;
+		}
+		Iterator operator+(difference_type n) const noexcept {
+			return Iterator(chunks_, index_ + n);
+		}
+		Iterator operator-(difference_type n) const noexcept {
+			return Iterator(chunks_, index_ - n);
+		}
+		friend Iterator operator+(difference_type n, const Iterator& it) noexcept {
+			return it + n;
+		}
+
+		// Сравнения и разность принимают и iterator, и const_iterator
+		template <bool C>
+		difference_type operator-(const Iterator<C>& other) const noexcept {
+			return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_);
+		}
+		template <bool C>
+		bool operator==(const Iterator<C>& other) const noexcept {
+			return index_ == other.index_;
+		}
+		template <bool C>
+		bool operator!=(const Iterator<C>& other) const noexcept {
+			return index_ != other.index_;
+		}
+		template <bool C>
+		bool operator<(const Iterator<C>& other) const noexcept {
+			return index_ < other.index_;
+		}
+		template <bool C>
+		bool operator>(const Iterator<C>& other) const noexcept {
+			return index_ > other.index_;
+		}
+		template <bool C>
+		bool operator<=(const Iterator<C>& other) const noexcept {
+			return index_ <= other.index_;
+		}
+		template <bool C>
+		bool operator>=(const Iterator<C>& other) const noexcept {
+			return index_ >= other.index_;
+		}
+
+	private:
+		template <bool C>
+		friend class Iterator;
+
+		Chunk* chunks_ = nullptr;
+		size_t index_ = 0;
+	};
+
+	using iterator = Iterator<false>;
+	using const_iterator = Iterator<true>;
+
+	ChunkedVector() = default;
+
+	// Деструктор не вызывается, если конструктор выбросил исключение: созданные элементы
+	// разрушаются здесь, а блоки освобождает деструктор поля chunks_
+	explicit ChunkedVector(size_t size) {
+		try {
+			Resize(size);
+		}
+		catch (...) {
+			Clear();
+			throw;
+		}
+	}
+
+	ChunkedVector(const ChunkedVector& other) {
+		Reserve(other.size_);
+		try {
+			other.ForEachChunk([this](const T* data, size_t count) {
+				for (size_t i = 0; i < count; ++i) {
+					EmplaceBack(data[i]);
+				}
+			});
+		}
+		catch (...) {
+			Clear();
+			throw;
+		}
+	}
+
+	ChunkedVector(ChunkedVector&& other) noexcept
+		: chunks_(std::move(other.chunks_))
+		, size_(std::exchange(other.size_, 0)) {
+	}
+
+	ChunkedVector& operator=(const ChunkedVector& rhs) {
+		if (this != &rhs) {
+			ChunkedVector copy(rhs);
+			Swap(copy);
+		}
+		return *this;
+	}
+
+	ChunkedVector& operator=(ChunkedVector&& rhs) noexcept {
+		if (this != &rhs) {
+			Clear();
+			Swap(rhs);
+		}
+		return *this;
+	}
+
+	~ChunkedVector() {
+		Clear();
+	}
+
+	iterator begin() noexcept {
+		return iterator(chunks_.begin(), 0);
+	}
+	iterator end() noexcept {
+		return iterator(chunks_.begin(), size_);
+	}
+	const_iterator begin() const noexcept {
+		return const_iterator(chunks_.begin(), 0);
+	}
+	const_iterator end() const noexcept {
+		return const_iterator(chunks_.begin(), size_);
+	}
+	const_iterator cbegin() const noexcept {
+		return begin();
+	}
+	const_iterator cend() const noexcept {
+		return end();
+	}
+
+	size_t Size() const noexcept {
+		return size_;
+	}
+
+	size_t Capacity() const noexcept {
+		return chunks_.Size() * CHUNK_SIZE;
+	}
+
+	size_t ChunkCount() const noexcept {
+		return chunks_.Size();
+	}
+
+	const T& operator[](size_t index) const noexcept {
+		return const_cast<ChunkedVector&>(*this)[index];
+	}
+
+	T& operator[](size_t index) noexcept {
+		assert(index < size_);
+		return chunks_[index >> CHUNK_SHIFT][index & (CHUNK_SIZE - 1)];
+	}
+
+	// Вызывает fn(data, count) для каждого непустого блока по порядку. Внутренний цикл
+	// по непрерывному блоку обходится без пересчёта индексов.
+	template <typename Fn>
+	void ForEachChunk(Fn&& fn) {
+		for (size_t first = 0; first < size_; first += CHUNK_SIZE) {
+			fn(chunks_[first >> CHUNK_SHIFT].GetAddress(), std::min(CHUNK_SIZE, size_ - first));
+		}
+	}
+
+	template <typename Fn>
+	void ForEachChunk(Fn&& fn) const {
+		for (size_t first = 0; first < size_; first += CHUNK_SIZE) {
+			fn(chunks_[first >> CHUNK_SHIFT].GetAddress(), std::min(CHUNK_SIZE, size_ - first));
+		}
+	}
+
+	// Выделяет блоки заранее, чтобы последующие добавления не обращались к аллокатору
+	void Reserve(size_t capacity) {
+		const size_t chunk_count = (capacity + CHUNK_SIZE - 1) >> CHUNK_SHIFT;
+		chunks_.Reserve(chunk_count);
+		while (chunks_.Size() < chunk_count) {
+			chunks_.EmplaceBack(CHUNK_SIZE);
+		}
+	}
+
+	// Освобождает блоки, не занятые элементами
+	void ShrinkToFit() {
+		const size_t chunk_count = (size_ + CHUNK_SIZE - 1) >> CHUNK_SHIFT;
+		chunks_.Resize(chunk_count);
+		chunks_.ShrinkToFit();
+	}
+
+	void Resize(size_t new_size) {
+		while (size_ > new_size) {
+			PopBack();
+		}
+		Reserve(new_size);
+		while (size_ < new_size) {
+			EmplaceBack();
+		}
+	}
+
+	// Элементы не перемещаются, поэтому аргументы могут ссылаться на элементы вектора.
+	// При исключении в конструкторе T вектор не изменяется.
+	template <typename... Args>
+	T& EmplaceBack(Args&&... args) {
+		if (size_ == Capacity()) {
+			// Переносится только индекс блоков, сами элементы остаются на месте
+			chunks_.EmplaceBack(CHUNK_SIZE);
+		}
+		T* elem = new(chunks_[size_ >> CHUNK_SHIFT] + (size_ & (CHUNK_SIZE - 1))) T(std::forward<Args>(args)...);
+		++size_;
+		return *elem;
+	}
+
+	void PushBack(const T& value) {
+		EmplaceBack(value);
+	}
+
+	void PushBack(T&& value) {
+		EmplaceBack(std::move(value));
+	}
+
+	void PopBack() noexcept {
+		assert(size_ != 0);
+		std::destroy_at(&(*this)[size_ - 1]);
+		--size_;
+	}
+
+	// Разрушает элементы, блоки остаются выделенными
+	void Clear() noexcept {
+		ForEachChunk([](T* data, size_t count) {
+			detail::DestroyN(data, count);
+		});
+		size_ = 0;
+	}
+
+	void Swap(ChunkedVector& other) noexcept {
+		chunks_.Swap(other.chunks_);
+		std::swap(size_, other.size_);
+	}
+
+	// Копирует элементы в непрерывный вектор
+	Vector<T> Flatten() const& {
+		Vector<T> result;
+		if constexpr (std::is_trivially_copyable_v<T>) {
+			result.ResizeForOverwrite(size_, [this](T* data, size_t count) {
+				ForEachChunk([&data](const T* chunk, size_t n) {
+					std::memcpy(data, chunk, n * sizeof(T));
+					data += n;
+				});
+				return count;
+			});
+		}
+		else {
+			result.Reserve(size_);
+			ForEachChunk([&result](const T* chunk, size_t n) {
+				for (size_t i = 0; i < n; ++i) {
+					result.EmplaceBack(chunk[i]);
+				}
+			});
+		}
+		return result;
+	}
+
+	// Перемещает элементы в непрерывный вектор; исходный вектор становится пустым
+	Vector<T> Flatten() && {
+		Vector<T> result;
+		result.Reserve(size_);
+		ForEachChunk([&result](T* chunk, size_t n) {
+			for (size_t i = 0; i < n; ++i) {
+				result.EmplaceBack(std::move_if_noexcept(chunk[i]));
+			}
+		});
+		Clear();
+		return result;
+	}
+
+private:
+	Vector<RawMemory<T>> chunks_;
+	size_t size_ = 0;
+};
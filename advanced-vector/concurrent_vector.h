@@ -0,0 +1,239 @@
+#pragma once
+#include "vector.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Вектор для одновременного добавления элементов из нескольких потоков. Хранит элементы
+// в сегментах RawMemory, размер которых растёт геометрически: сегмент k вмещает
+// FirstSegment * 2^k элементов. Элементы никогда не перемещаются, поэтому ссылки на них
+// остаются действительными.
+// Писатели резервируют слоты атомарно и отмечают готовность элемента в битовой карте
+// сегмента. Читатели без блокировок видят опубликованный префикс — все элементы до
+// первого ещё не сконструированного. Конструирование после резервирования слота не должно
+// выбрасывать исключений: иначе префикс не смог бы продвинуться дальше этого слота.
+template <typename T, size_t FirstSegment = 64>
+class ConcurrentVector {
+	static_assert(FirstSegment >= 64 && (FirstSegment & (FirstSegment - 1)) == 0,
+		"FirstSegment must be a power of two not less than 64");
+
+	using Word = std::uint64_t;
+	static constexpr size_t WORD_BITS = 64;
+	static constexpr size_t FIRST_SEGMENT_LOG = detail::FloorLog2(FirstSegment);
+	static constexpr size_t MAX_SEGMENTS = std::numeric_limits<size_t>::digits - FIRST_SEGMENT_LOG;
+
+public:
+	class ConstIterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T&;
+
+		ConstIterator(const ConcurrentVector* vector, size_t index) noexcept
+			: vector_(vector)
+			, index_(index) {
+		}
+
+		reference operator*() const noexcept {
+			return (*vector_)[index_];
+		}
+		pointer operator->() const noexcept {
+			return &(*vector_)[index_];
+		}
+		ConstIterator& operator++() noexcept {
+			++index_;
+			return *this;
+		}
+		ConstIterator operator++(int) noexcept {
+			ConstIterator old = *this;
+			++index_;
+			return old;
+		}
+		bool operator==(const ConstIterator& other) const noexcept {
+			return index_ == other.index_;
+		}
+		bool operator!=(const ConstIterator& other) const noexcept {
+			return index_ != other.index_;
+		}
+
+	private:
+		const ConcurrentVector* vector_;
+		size_t index_;
+	};
+
+	using const_iterator = ConstIterator;
+
+	ConcurrentVector() = default;
+	ConcurrentVector(const ConcurrentVector&) = delete;
+	ConcurrentVector& operator=(const ConcurrentVector&) = delete;
+
+	// Вызывается, когда писателей уже нет: все зарезервированные слоты сконструированы
+	~ConcurrentVector() {
+		const size_t size = reserved_.load(std::memory_order_acquire);
+		for (size_t segment = 0; segment < MAX_SEGMENTS; ++segment) {
+			const size_t first = SegmentStart(segment);
+			if (first >= size) {
+				break;
+			}
+			detail::DestroyN(elements_[segment].load(std::memory_order_relaxed),
+				std::min(size - first, SegmentSize(segment)));
+		}
+	}
+
+	template <typename... Args>
+	T& EmplaceBack(Args&&... args) {
+		if constexpr (std::is_nothrow_constructible_v<T, Args&&...>) {
+			const size_t index = ReserveSlots(1);
+			T* elem = new(SlotAddress(index)) T(std::forward<Args>(args)...);
+			MarkReady(index);
+			return *elem;
+		}
+		else {
+			static_assert(std::is_nothrow_move_constructible_v<T>,
+				"T must be nothrow constructible from the arguments or nothrow move constructible");
+			// Исключение возможно только до резервирования слота
+			T tmp(std::forward<Args>(args)...);
+			return EmplaceBack(std::move(tmp));
+		}
+	}
+
+	T& PushBack(const T& value) {
+		return EmplaceBack(value);
+	}
+
+	T& PushBack(T&& value) {
+		return EmplaceBack(std::move(value));
+	}
+
+	// Добавляет count элементов, инициализированных значением по умолчанию, в подряд идущие
+	// слоты. Возвращает индекс первого из них.
+	size_t GrowBy(size_t count) {
+		static_assert(std::is_nothrow_default_constructible_v<T>);
+		const size_t first = ReserveSlots(count);
+		for (size_t index = first; index < first + count; ++index) {
+			new(SlotAddress(index)) T();
+			MarkReady(index);
+		}
+		return first;
+	}
+
+	// Длина опубликованного префикса: все элементы с меньшими индексами сконструированы
+	// и видны вызывающему потоку
+	size_t Size() const noexcept {
+		size_t published = published_.load(std::memory_order_acquire);
+		const size_t reserved = reserved_.load(std::memory_order_acquire);
+		while (published < reserved && IsReady(published)) {
+			if (published_.compare_exchange_weak(published, published + 1, std::memory_order_acq_rel)) {
+				++published;
+			}
+		}
+		return published;
+	}
+
+	// Количество зарезервированных слотов, включая ещё не опубликованные
+	size_t ReservedSize() const noexcept {
+		return reserved_.load(std::memory_order_relaxed);
+	}
+
+	// Индекс должен быть меньше значения, ранее полученного из Size()
+	const T& operator[](size_t index) const noexcept {
+		return const_cast<ConcurrentVector&>(*this)[index];
+	}
+
+	T& operator[](size_t index) noexcept {
+		assert(index < reserved_.load(std::memory_order_relaxed));
+		return *SlotAddress(index);
+	}
+
+	const_iterator begin() const noexcept {
+		return ConstIterator(this, 0);
+	}
+	const_iterator end() const noexcept {
+		return ConstIterator(this, Size());
+	}
+
+private:
+	static constexpr size_t SegmentOf(size_t index) noexcept {
+		return detail::FloorLog2((index >> FIRST_SEGMENT_LOG) + 1);
+	}
+
+	static constexpr size_t SegmentStart(size_t segment) noexcept {
+		return (((size_t{ 1 } << segment) - 1) << FIRST_SEGMENT_LOG);
+	}
+
+	static constexpr size_t SegmentSize(size_t segment) noexcept {
+		return FirstSegment << segment;
+	}
+
+	T* SlotAddress(size_t index) const noexcept {
+		const size_t segment = SegmentOf(index);
+		return elements_[segment].load(std::memory_order_acquire) + (index - SegmentStart(segment));
+	}
+
+	void MarkReady(size_t index) noexcept {
+		const size_t segment = SegmentOf(index);
+		const size_t offset = index - SegmentStart(segment);
+		ready_[segment].load(std::memory_order_acquire)[offset / WORD_BITS]
+			.fetch_or(Word{ 1 } << (offset % WORD_BITS), std::memory_order_release);
+	}
+
+	bool IsReady(size_t index) const noexcept {
+		const size_t segment = SegmentOf(index);
+		const size_t offset = index - SegmentStart(segment);
+		const Word word = ready_[segment].load(std::memory_order_acquire)[offset / WORD_BITS]
+			.load(std::memory_order_acquire);
+		return (word >> (offset % WORD_BITS)) & 1;
+	}
+
+	// Сегменты выделяются до резервирования слотов, поэтому после резервирования
+	// нехватка памяти уже невозможна
+	size_t ReserveSlots(size_t count) {
+		size_t first = reserved_.load(std::memory_order_relaxed);
+		do {
+			if (count != 0) {
+				EnsureSegments(first + count - 1);
+			}
+		} while (!reserved_.compare_exchange_weak(first, first + count, std::memory_order_relaxed));
+		return first;
+	}
+
+	void EnsureSegments(size_t last_index) {
+		const size_t last_segment = SegmentOf(last_index);
+		assert(last_segment < MAX_SEGMENTS);
+		if (elements_[last_segment].load(std::memory_order_acquire) != nullptr) {
+			return;
+		}
+		std::lock_guard guard(segments_mutex_);
+		for (size_t segment = 0; segment <= last_segment; ++segment) {
+			if (elements_[segment].load(std::memory_order_relaxed) != nullptr) {
+				continue;
+			}
+			RawMemory<T> elements(SegmentSize(segment));
+			RawMemory<std::atomic<Word>> ready(SegmentSize(segment) / WORD_BITS);
+			for (size_t word = 0; word < ready.Capacity(); ++word) {
+				new(ready + word) std::atomic<Word>(0);
+			}
+			element_blocks_[segment].Swap(elements);
+			ready_blocks_[segment].Swap(ready);
+			ready_[segment].store(ready_blocks_[segment].GetAddress(), std::memory_order_release);
+			elements_[segment].store(element_blocks_[segment].GetAddress(), std::memory_order_release);
+		}
+	}
+
+	std::atomic<size_t> reserved_{ 0 };
+	mutable std::atomic<size_t> published_{ 0 };
+	std::atomic<T*> elements_[MAX_SEGMENTS] = {};
+	std::atomic<std::atomic<Word>*> ready_[MAX_SEGMENTS] = {};
+
+	std::mutex segments_mutex_;
+	RawMemory<T> element_blocks_[MAX_SEGMENTS];
+	RawMemory<std::atomic<Word>> ready_blocks_[MAX_SEGMENTS];
+};
@@ -0,0 +1,301 @@
+#pragma once
+#include "vector.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+
+template <typename T>
+class AtomicCowVector;
+
+// Вектор с копированием при записи. Копии разделяют один буфер со счётчиком ссылок
+// и копируются за O(1); изменяющие методы (неконстантные operator[], begin() и end(),
+// EmplaceBack, Erase и т.д.) сначала получают собственную копию элементов, если буфер разделён.
+// Только читающий код должен обращаться к вектору через константную ссылку или View(),
+// иначе неконстантный operator[] скопирует разделённый буфер.
+// Копии можно читать и изменять в разных потоках; один объект, как и Vector,
+// нельзя одновременно изменять и читать.
+template <typename T>
+class CowVector {
+	struct Shared {
+		explicit Shared(Vector<T>&& elements) noexcept
+			: elements(std::move(elements)) {
+		}
+
+		std::atomic<size_t> refs{ 1 };
+		Vector<T> elements;
+	};
+
+public:
+	using iterator = T*;
+	using const_iterator = const T*;
+
+	CowVector() = default;
+
+	explicit CowVector(Vector<T> elements)
+		: shared_(new Shared(std::move(elements))) {
+	}
+
+	CowVector(const CowVector& other) noexcept
+		: shared_(other.shared_) {
+		if (shared_ != nullptr) {
+			shared_->refs.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	CowVector(CowVector&& other) noexcept
+		: shared_(std::exchange(other.shared_, nullptr)) {
+	}
+
+	CowVector& operator=(const CowVector& rhs) noexcept {
+		CowVector copy(rhs);
+		Swap(copy);
+		return *this;
+	}
+
+	CowVector& operator=(CowVector&& rhs) noexcept {
+		CowVector moved(std::move(rhs));
+		Swap(moved);
+		return *this;
+	}
+
+	~CowVector() {
+		Unref(shared_);
+	}
+
+	const_iterator begin() const noexcept {
+		return View().begin();
+	}
+	const_iterator end() const noexcept {
+		return View().end();
+	}
+	const_iterator cbegin() const noexcept {
+		return begin();
+	}
+	const_iterator cend() const noexcept {
+		return end();
+	}
+	iterator begin() {
+		return Detach().begin();
+	}
+	iterator end() {
+		return Detach().end();
+	}
+
+	// Элементы без копирования
+	const Vector<T>& View() const noexcept {
+		static const Vector<T> empty;
+		return shared_ != nullptr ? shared_->elements : empty;
+	}
+
+	size_t Size() const noexcept {
+		return View().Size();
+	}
+
+	size_t Capacity() const noexcept {
+		return View().Capacity();
+	}
+
+	// Число векторов, разделяющих буфер (0 для пустого вектора без буфера)
+	size_t UseCount() const noexcept {
+		return shared_ != nullptr ? shared_->refs.load(std::memory_order_relaxed) : 0;
+	}
+
+	const T& operator[](size_t index) const noexcept {
+		return View()[index];
+	}
+
+	T& operator[](size_t index) {
+		assert(index < Size());
+		return Detach()[index];
+	}
+
+	// Разделённый буфер копируется сразу с запасом под новый элемент. Аргументы могут
+	// ссылаться на его элементы, поэтому он удерживается до конца вставки.
+	template <typename... Args>
+	T& EmplaceBack(Args&&... args) {
+		const CowVector previous = UseCount() > 1 ? *this : CowVector();
+		return Detach(Size() + 1).EmplaceBack(std::forward<Args>(args)...);
+	}
+
+	void PushBack(const T& value) {
+		EmplaceBack(value);
+	}
+
+	void PushBack(T&& value) {
+		EmplaceBack(std::move(value));
+	}
+
+	void PopBack() {
+		assert(Size() != 0);
+		Detach().PopBack();
+	}
+
+	template <typename... Args>
+	iterator Emplace(const_iterator pos, Args&&... args) {
+		const size_t distance = pos - cbegin();
+		const CowVector previous = UseCount() > 1 ? *this : CowVector();
+		Vector<T>& elements = Detach(Size() + 1);
+		return elements.Emplace(elements.cbegin() + distance, std::forward<Args>(args)...);
+	}
+
+	iterator Insert(const_iterator pos, const T& value) {
+		return Emplace(pos, value);
+	}
+
+	iterator Insert(const_iterator pos, T&& value) {
+		return Emplace(pos, std::move(value));
+	}
+
+	iterator Erase(const_iterator pos) {
+		const size_t distance = pos - cbegin();
+		Vector<T>& elements = Detach();
+		return elements.Erase(elements.cbegin() + distance);
+	}
+
+	iterator Erase(const_iterator first, const_iterator last) {
+		const size_t distance = first - cbegin();
+		const size_t count = last - first;
+		Vector<T>& elements = Detach();
+		return elements.Erase(elements.cbegin() + distance, elements.cbegin() + distance + count);
+	}
+
+	void Resize(size_t new_size) {
+		Detach(new_size).Resize(new_size);
+	}
+
+	void Reserve(size_t capacity) {
+		Detach(capacity).Reserve(capacity);
+	}
+
+	// Разделённый буфер не копируется: вектор просто отказывается от своей ссылки
+	void Clear() noexcept {
+		if (UseCount() > 1) {
+			Unref(std::exchange(shared_, nullptr));
+		}
+		else if (shared_ != nullptr) {
+			shared_->elements.Clear();
+		}
+	}
+
+	void Swap(CowVector& other) noexcept {
+		std::swap(shared_, other.shared_);
+	}
+
+private:
+	friend class AtomicCowVector<T>;
+
+	// Принимает уже учтённую ссылку на буфер
+	explicit CowVector(Shared* shared) noexcept
+		: shared_(shared) {
+	}
+
+	static void Unref(Shared* shared) noexcept {
+		if (shared != nullptr && shared->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			delete shared;
+		}
+	}
+
+	// Делает буфер собственным. Копия разделённого буфера сразу вмещает capacity элементов.
+	// При исключении вектор не меняется.
+	Vector<T>& Detach(size_t capacity = 0) {
+		if (shared_ == nullptr) {
+			shared_ = new Shared(Vector<T>());
+		}
+		else if (shared_->refs.load(std::memory_order_acquire) != 1) {
+			const Vector<T>& old = shared_->elements;
+			Vector<T> elements;
+			elements.Reserve(std::max({ capacity, old.Size(), size_t{ 1 } }));
+			elements.Append(old.begin(), old.end());
+			Unref(std::exchange(shared_, new Shared(std::move(elements))));
+		}
+		return shared_->elements;
+	}
+
+	Shared* shared_ = nullptr;
+};
+
+// Ячейка с текущей версией CowVector: писатель публикует новую версию атомарной заменой
+// указателя, читатели без блокировок получают снимок — CowVector, разделяющий буфер версии.
+// Счётчик ссылок разделён на две части: читатель сначала увеличивает счётчик в старших битах
+// слова ячейки и только потом — счётчик буфера, поэтому писатель не может освободить буфер,
+// пока читатель его захватывает. Заменяя буфер, писатель переносит накопленные в ячейке
+// захваты в счётчик старого буфера.
+template <typename T>
+class AtomicCowVector {
+	using Shared = typename CowVector<T>::Shared;
+
+	// Адреса в пространстве пользователя на x86-64 и AArch64 умещаются в 48 бит
+	static_assert(sizeof(void*) == 8, "AtomicCowVector requires 64-bit pointers");
+	static constexpr int COUNT_SHIFT = 48;
+	static constexpr std::uintptr_t COUNT_ONE = std::uintptr_t{ 1 } << COUNT_SHIFT;
+	static constexpr std::uintptr_t POINTER_MASK = COUNT_ONE - 1;
+
+public:
+	AtomicCowVector() = default;
+
+	explicit AtomicCowVector(CowVector<T> initial) noexcept
+		: state_(Pack(std::exchange(initial.shared_, nullptr))) {
+	}
+
+	AtomicCowVector(const AtomicCowVector&) = delete;
+	AtomicCowVector& operator=(const AtomicCowVector&) = delete;
+
+	~AtomicCowVector() {
+		Exchange(CowVector<T>());
+	}
+
+	// Снимок текущей версии; не блокируется и не копирует элементы
+	CowVector<T> Load() const noexcept {
+		const std::uintptr_t state = state_.fetch_add(COUNT_ONE, std::memory_order_acquire);
+		Shared* shared = ToShared(state);
+		if (shared != nullptr) {
+			shared->refs.fetch_add(1, std::memory_order_relaxed);
+		}
+		ReturnLocalCount(shared);
+		return CowVector<T>(shared);
+	}
+
+	void Store(CowVector<T> version) noexcept {
+		Exchange(std::move(version));
+	}
+
+	// Публикует новую версию и возвращает предыдущую
+	CowVector<T> Exchange(CowVector<T> version) noexcept {
+		const std::uintptr_t next = Pack(std::exchange(version.shared_, nullptr));
+		const std::uintptr_t state = state_.exchange(next, std::memory_order_acq_rel);
+		Shared* previous = ToShared(state);
+		if (previous != nullptr) {
+			previous->refs.fetch_add(state >> COUNT_SHIFT, std::memory_order_relaxed);
+		}
+		// Ссылка ячейки переходит к возвращаемому вектору
+		return CowVector<T>(previous);
+	}
+
+private:
+	static Shared* ToShared(std::uintptr_t state) noexcept {
+		return reinterpret_cast<Shared*>(state & POINTER_MASK);
+	}
+
+	static std::uintptr_t Pack(Shared* shared) noexcept {
+		const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(shared);
+		assert((address & ~POINTER_MASK) == 0);
+		return address;
+	}
+
+	// Снимает захват читателя со слова ячейки. Если буфер успели заменить, писатель уже
+	// перенёс захват в счётчик буфера, и снимать его нужно там.
+	void ReturnLocalCount(Shared* shared) const noexcept {
+		std::uintptr_t state = state_.load(std::memory_order_relaxed);
+		while (ToShared(state) == shared && (state >> COUNT_SHIFT) != 0) {
+			if (state_.compare_exchange_weak(state, state - COUNT_ONE, std::memory_order_release,
+				std::memory_order_relaxed)) {
+				return;
+			}
+		}
+		CowVector<T>::Unref(shared);
+	}
+
+	mutable std::atomic<std::uintptr_t> state_{ 0 };
+};
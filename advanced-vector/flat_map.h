@@ -0,0 +1,741 @@
+#pragma once
+#include "vector.h"
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+namespace detail {
+
+// Двоичный поиск без ветвлений: на каждом шаге выбирается половина через условное присваивание,
+// поэтому процессору нечего предсказывать. Возвращает позицию первого элемента, не меньшего key.
+template <typename K, typename Key, typename Compare>
+size_t BranchlessLowerBound(const K* data, size_t n, const Key& key, const Compare& comp) {
+	if (n == 0) {
+		return 0;
+	}
+	const K* base = data;
+	while (n > 1) {
+		const size_t half = n / 2;
+		base = comp(base[half], key) ? base + half : base;
+		n -= half;
+	}
+	return (base - data) + (comp(*base, key) ? 1 : 0);
+}
+
+// Копия ключей в порядке Эйтцингера (обход неявного двоичного дерева в ширину) для поиска
+// в неизменяемом контейнере: первые уровни дерева лежат рядом и остаются в кеше, а потомки
+// узла k, 2k и 2k + 1, подгружаются заранее несколькими уровнями ниже. Позиция ключа
+// в отсортированном массиве вычисляется по номеру узла, без отдельной таблицы.
+template <typename K>
+class EytzingerIndex {
+public:
+	bool Empty() const noexcept {
+		return keys_.Size() == 0;
+	}
+
+	void Build(const Vector<K>& sorted) {
+		const size_t n = sorted.Size();
+		Vector<K> keys;
+		keys.Reserve(n);
+		for (size_t k = 1; k <= n; ++k) {
+			keys.PushBack(sorted[Rank(k, n)]);
+		}
+		keys_.Swap(keys);
+	}
+
+	void Clear() noexcept {
+		keys_ = Vector<K>();
+	}
+
+	// Позиция первого ключа, не меньшего key, в отсортированном массиве и признак того,
+	// что этот ключ равен key. Равенство проверяется по ключу узла, который уже в кеше.
+	template <typename Key, typename Compare>
+	std::pair<size_t, bool> Lookup(const Key& key, const Compare& comp) const {
+		const size_t n = keys_.Size();
+		size_t k = 1;
+		while (k <= n) {
+#if defined(__GNUC__) || defined(__clang__)
+			// Потомки узла через четыре уровня лежат подряд
+			__builtin_prefetch(keys_.begin() + std::min(k * 16, n) - 1);
+#endif
+			k = 2 * k + (comp(keys_[k - 1], key) ? 1 : 0);
+		}
+		// Отменяет последние переходы вправо и ещё один переход влево
+		while (k & 1) {
+			k >>= 1;
+		}
+		k >>= 1;
+		return { Rank(k, n), k != 0 && !comp(key, keys_[k - 1]) };
+	}
+
+private:
+	// Позиция узла k при симметричном обходе дерева из n узлов; n для узла 0.
+	// В полном дереве высоты height + 1 узел j уровня depth стоит на позиции
+	// (2j + 1) * 2^(height - depth) - 1, а узлы нижнего уровня — на чётных позициях;
+	// из неё вычитаются отсутствующие узлы нижнего уровня левее узла.
+	static size_t Rank(size_t k, size_t n) noexcept {
+		if (k == 0) {
+			return n;
+		}
+		const size_t height = FloorLog2(n);
+		const size_t depth = FloorLog2(k);
+		const size_t last_level = n - ((size_t{ 1 } << height) - 1);
+		const size_t full = ((2 * (k - (size_t{ 1 } << depth)) + 1) << (height - depth)) - 1;
+		const size_t left_bottom = (full + 1) / 2;
+		return full - (left_bottom > last_level ? left_bottom - last_level : 0);
+	}
+
+	Vector<K> keys_;
+};
+
+// Поиск в отсортированных ключах flat-контейнера: по индексу, если он построен
+template <typename K, typename Compare>
+std::pair<size_t, bool> FlatLookup(const Vector<K>& keys, const EytzingerIndex<K>& index,
+	const K& key, const Compare& comp) {
+	if (!index.Empty()) {
+		return index.Lookup(key, comp);
+	}
+	const size_t pos = BranchlessLowerBound(keys.begin(), keys.Size(), key, comp);
+	return { pos, pos != keys.Size() && !comp(key, keys[pos]) };
+}
+
+}  // namespace detail
+
+// Упорядоченное множество в отсортированном Vector. Поиск — двоичный без ветвлений или,
+// после BuildSearchIndex(), по индексу в порядке Эйтцингера. Вставка и удаление одного ключа
+// сдвигают хвост, поэтому добавлять много ключей выгоднее одним InsertMany.
+// Ключи неизменяемы: итераторы константные.
+template <typename K, typename Compare = std::less<K>>
+class FlatSet {
+public:
+	using iterator = const K*;
+	using const_iterator = const K*;
+
+	FlatSet() = default;
+
+	explicit FlatSet(const Compare& comp)
+		: comp_(comp) {
+	}
+
+	// Сортирует и удаляет повторы на месте, не выделяя память. Какой из равных ключей
+	// останется, не определено.
+	explicit FlatSet(Vector<K> keys, const Compare& comp = Compare())
+		: keys_(std::move(keys))
+		, comp_(comp) {
+		SortUnique(keys_);
+	}
+
+	// Для forward-итераторов память выделяется один раз
+	template <typename InputIt, typename = detail::RequireInputIterator<InputIt>>
+	FlatSet(InputIt first, InputIt last, const Compare& comp = Compare())
+		: comp_(comp) {
+		keys_.Append(first, last);
+		SortUnique(keys_);
+	}
+
+	FlatSet(std::initializer_list<K> keys, const Compare& comp = Compare())
+		: FlatSet(keys.begin(), keys.end(), comp) {
+	}
+
+	const_iterator begin() const noexcept {
+		return keys_.begin();
+	}
+	const_iterator end() const noexcept {
+		return keys_.end();
+	}
+
+	size_t Size() const noexcept {
+		return keys_.Size();
+	}
+
+	bool Empty() const noexcept {
+		return keys_.Size() == 0;
+	}
+
+	const Vector<K>& Keys() const noexcept {
+		return keys_;
+	}
+
+	const_iterator LowerBound(const K& key) const {
+		return keys_.begin() + Lookup(key).first;
+	}
+
+	const_iterator UpperBound(const K& key) const {
+		return std::upper_bound(keys_.begin(), keys_.end(), key, comp_);
+	}
+
+	const_iterator Find(const K& key) const {
+		const auto [pos, found] = Lookup(key);
+		return found ? keys_.begin() + pos : end();
+	}
+
+	bool Contains(const K& key) const {
+		return Lookup(key).second;
+	}
+
+	size_t Count(const K& key) const {
+		return Contains(key) ? 1 : 0;
+	}
+
+	void Reserve(size_t capacity) {
+		keys_.Reserve(capacity);
+	}
+
+	// Строит индекс для быстрого поиска. Любое изменение множества сбрасывает индекс.
+	void BuildSearchIndex() {
+		index_.Build(keys_);
+	}
+
+	bool HasSearchIndex() const noexcept {
+		return !index_.Empty();
+	}
+
+	std::pair<const_iterator, bool> Insert(K key) {
+		const auto [pos, found] = Lookup(key);
+		if (found) {
+			return { keys_.begin() + pos, false };
+		}
+		index_.Clear();
+		return { keys_.Insert(keys_.cbegin() + pos, std::move(key)), true };
+	}
+
+	// Сортирует пакет, отбрасывает уже имеющиеся ключи, дописывает остальные в конец
+	// одной вставкой диапазона и сливает их с ключами множества от конца к началу, так что
+	// каждый ключ перемещается не больше одного раза. Равные ключи пакета не заменяют
+	// имеющиеся. Если при слиянии перемещение ключа бросило исключение, множество очищается.
+	template <typename InputIt, typename = detail::RequireInputIterator<InputIt>>
+	void InsertMany(InputIt first, InputIt last) {
+		Vector<K> batch;
+		batch.Append(first, last);
+		SortUnique(batch);
+		batch.EraseIf([this](const K& key) {
+			return Contains(key);
+		});
+		if (batch.Size() == 0) {
+			return;
+		}
+		index_.Clear();
+		const size_t old_size = keys_.Size();
+		const bool append_only = old_size == 0 || comp_(keys_[old_size - 1], batch[0]);
+		keys_.Append(std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+		if (append_only) {
+			return;
+		}
+		try {
+			// Ключи пакета возвращаются в batch, а хвост становится местом для слияния
+			std::swap_ranges(keys_.begin() + old_size, keys_.end(), batch.begin());
+			size_t i = old_size;
+			size_t j = batch.Size();
+			for (size_t out = keys_.Size(); j != 0;) {
+				--out;
+				if (i != 0 && comp_(batch[j - 1], keys_[i - 1])) {
+					keys_[out] = std::move(keys_[--i]);
+				}
+				else {
+					keys_[out] = std::move(batch[--j]);
+				}
+			}
+		}
+		catch (...) {
+			keys_.Clear();
+			throw;
+		}
+	}
+
+	void InsertMany(std::initializer_list<K> keys) {
+		InsertMany(keys.begin(), keys.end());
+	}
+
+	size_t Erase(const K& key) {
+		const_iterator it = Find(key);
+		if (it == end()) {
+			return 0;
+		}
+		Erase(it);
+		return 1;
+	}
+
+	const_iterator Erase(const_iterator pos) {
+		index_.Clear();
+		return keys_.Erase(pos);
+	}
+
+	const_iterator Erase(const_iterator first, const_iterator last) {
+		index_.Clear();
+		return keys_.Erase(first, last);
+	}
+
+	// Удаляет ключи, удовлетворяющие предикату, за один проход
+	template <typename Predicate>
+	size_t EraseIf(Predicate pred) {
+		index_.Clear();
+		return keys_.EraseIf(pred);
+	}
+
+	void Clear() noexcept {
+		index_.Clear();
+		keys_.Clear();
+	}
+
+	void Swap(FlatSet& other) noexcept {
+		keys_.Swap(other.keys_);
+		std::swap(index_, other.index_);
+		std::swap(comp_, other.comp_);
+	}
+
+private:
+	std::pair<size_t, bool> Lookup(const K& key) const {
+		return detail::FlatLookup(keys_, index_, key, comp_);
+	}
+
+	void SortUnique(Vector<K>& keys) const {
+		std::sort(keys.begin(), keys.end(), comp_);
+		keys.Erase(std::unique(keys.begin(), keys.end(), [this](const K& lhs, const K& rhs) {
+			return !comp_(lhs, rhs);
+		}), keys.cend());
+	}
+
+	Vector<K> keys_;
+	detail::EytzingerIndex<K> index_;
+	[[no_unique_address]] Compare comp_;
+};
+
+// Упорядоченный словарь из отсортированного вектора ключей и параллельного вектора значений:
+// поиск просматривает только плотный массив ключей. Поиск, пакетные операции и стоимость
+// одиночных вставок такие же, как у FlatSet. Итераторы возвращают пары ссылок
+// std::pair<const K&, V&>.
+template <typename K, typename V, typename Compare = std::less<K>>
+class FlatMap {
+public:
+	template <bool Const>
+	class Iterator {
+		using Value = std::conditional_t<Const, const V, V>;
+
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = std::pair<K, V>;
+		using difference_type = std::ptrdiff_t;
+		using reference = std::pair<const K&, Value&>;
+
+		// Для it->first и it->second: пара ссылок живёт, пока вычисляется выражение
+		struct pointer {
+			const reference* operator->() const noexcept {
+				return &ref;
+			}
+			reference ref;
+		};
+
+		Iterator() = default;
+
+		Iterator(const K* key, Value* value) noexcept
+			: key_(key)
+			, value_(value) {
+		}
+
+		operator Iterator<true>() const noexcept {
+			return Iterator<true>(key_, value_);
+		}
+
+		reference operator*() const noexcept {
+			return { *key_, *value_ };
+		}
+		pointer operator->() const noexcept {
+			return { **this };
+		}
+		reference operator[](difference_type n) const noexcept {
+			return { key_[n], value_[n] };
+		}
+		const K& Key() const noexcept {
+			return *key_;
+		}
+		Value& GetValue() const noexcept {
+			return *value_;
+		}
+		Iterator& operator++() noexcept {
+			++key_;
+			++value_;
+			return *this;
+		}
+		Iterator operator++(int) noexcept {
+			Iterator old = *this;
+			++*this;
+			return old;
+		}
+		Iterator& operator--() noexcept {
+			--key_;
+			--value_;
+			return *this;
+		}
+		Iterator operator--(int) noexcept {
+			Iterator old = *this;
+			--*this;
+			return old;
+		}
+		Iterator& operator+=(difference_type n) noexcept {
+			key_ += n;
+			value_ += n;
+			return *this;
+		}
+		Iterator& operator-=(difference_type n) noexcept {
+			return *this += -n;
+		}
+		Iterator operator+(difference_type n) const noexcept {
+			return Iterator(key_ + n, value_ + n);
+		}
+		Iterator operator-(difference_type n) const noexcept {
+			return Iterator(key_ - n, value_ - n);
+		}
+		friend Iterator operator+(difference_type n, const Iterator& it) noexcept {
+			return it + n;
+		}
+
+		// Сравнения и разность принимают и iterator, и const_iterator: m.Find(k) != m.cend()
+		template <bool C>
+		difference_type operator-(const Iterator<C>& other) const noexcept {
+			return key_ - other.key_;
+		}
+		template <bool C>
+		bool operator==(const Iterator<C>& other) const noexcept {
+			return key_ == other.key_;
+		}
+		template <bool C>
+		bool operator!=(const Iterator<C>& other) const noexcept {
+			return key_ != other.key_;
+		}
+		template <bool C>
+		bool operator<(const Iterator<C>& other) const noexcept {
+			return key_ < other.key_;
+		}
+		template <bool C>
+		bool operator>(const Iterator<C>& other) const noexcept {
+			return key_ > other.key_;
+		}
+		template <bool C>
+		bool operator<=(const Iterator<C>& other) const noexcept {
+			return key_ <= other.key_;
+		}
+		template <bool C>
+		bool operator>=(const Iterator<C>& other) const noexcept {
+			return key_ >= other.key_;
+		}
+
+	private:
+		template <bool C>
+		friend class Iterator;
+
+		const K* key_ = nullptr;
+		Value* value_ = nullptr;
+	};
+
+	using iterator = Iterator<false>;
+	using const_iterator = Iterator<true>;
+
+	FlatMap() = default;
+
+	explicit FlatMap(const Compare& comp)
+		: comp_(comp) {
+	}
+
+	// Пары сортируются устойчиво, из пар с равными ключами остаётся первая, как в std::map.
+	// Векторы ключей и значений выделяются по одному разу точно под результат.
+	template <typename InputIt, typename = detail::RequireInputIterator<InputIt>>
+	FlatMap(InputIt first, InputIt last, const Compare& comp = Compare())
+		: comp_(comp) {
+		Vector<std::pair<K, V>> items = PrepareBatch(first, last);
+		keys_.Reserve(items.Size());
+		values_.Reserve(items.Size());
+		for (auto& item : items) {
+			keys_.EmplaceBack(std::move(item.first));
+			values_.EmplaceBack(std::move(item.second));
+		}
+	}
+
+	FlatMap(std::initializer_list<std::pair<K, V>> items, const Compare& comp = Compare())
+		: FlatMap(items.begin(), items.end(), comp) {
+	}
+
+	iterator begin() noexcept {
+		return iterator(keys_.begin(), values_.begin());
+	}
+	iterator end() noexcept {
+		return iterator(keys_.end(), values_.end());
+	}
+	const_iterator begin() const noexcept {
+		return const_iterator(keys_.begin(), values_.begin());
+	}
+	const_iterator end() const noexcept {
+		return const_iterator(keys_.end(), values_.end());
+	}
+	const_iterator cbegin() const noexcept {
+		return begin();
+	}
+	const_iterator cend() const noexcept {
+		return end();
+	}
+
+	size_t Size() const noexcept {
+		return keys_.Size();
+	}
+
+	bool Empty() const noexcept {
+		return keys_.Size() == 0;
+	}
+
+	const Vector<K>& Keys() const noexcept {
+		return keys_;
+	}
+
+	const Vector<V>& Values() const noexcept {
+		return values_;
+	}
+
+	VectorView<V> Values() noexcept {
+		return VectorView<V>(values_);
+	}
+
+	iterator LowerBound(const K& key) {
+		return begin() + Lookup(key).first;
+	}
+
+	const_iterator LowerBound(const K& key) const {
+		return begin() + Lookup(key).first;
+	}
+
+	iterator Find(const K& key) {
+		const auto [pos, found] = Lookup(key);
+		return found ? begin() + pos : end();
+	}
+
+	const_iterator Find(const K& key) const {
+		const auto [pos, found] = Lookup(key);
+		return found ? begin() + pos : end();
+	}
+
+	bool Contains(const K& key) const {
+		return Lookup(key).second;
+	}
+
+	size_t Count(const K& key) const {
+		return Contains(key) ? 1 : 0;
+	}
+
+	V& At(const K& key) {
+		const auto [pos, found] = Lookup(key);
+		if (!found) {
+			throw std::out_of_range("FlatMap has no such key");
+		}
+		return values_[pos];
+	}
+
+	const V& At(const K& key) const {
+		return const_cast<FlatMap&>(*this).At(key);
+	}
+
+	V& operator[](const K& key) {
+		return TryEmplace(key).first.GetValue();
+	}
+
+	void Reserve(size_t capacity) {
+		keys_.Reserve(capacity);
+		values_.Reserve(capacity);
+	}
+
+	// Строит индекс для быстрого поиска. Любое изменение набора ключей сбрасывает индекс.
+	void BuildSearchIndex() {
+		index_.Build(keys_);
+	}
+
+	bool HasSearchIndex() const noexcept {
+		return !index_.Empty();
+	}
+
+	// Если ключ уже есть, значение не создаётся. При исключении словарь не изменяется.
+	template <typename... Args>
+	std::pair<iterator, bool> TryEmplace(K key, Args&&... args) {
+		const auto [pos, found] = Lookup(key);
+		if (found) {
+			return { begin() + pos, false };
+		}
+		index_.Clear();
+		values_.Emplace(values_.cbegin() + pos, std::forward<Args>(args)...);
+		try {
+			keys_.Insert(keys_.cbegin() + pos, std::move(key));
+		}
+		catch (...) {
+			values_.Erase(values_.cbegin() + pos);
+			throw;
+		}
+		return { begin() + pos, true };
+	}
+
+	std::pair<iterator, bool> Insert(K key, V value) {
+		return TryEmplace(std::move(key), std::move(value));
+	}
+
+	std::pair<iterator, bool> InsertOrAssign(K key, V value) {
+		auto [it, inserted] = TryEmplace(std::move(key), std::move(value));
+		if (!inserted) {
+			it.GetValue() = std::move(value);
+		}
+		return { it, inserted };
+	}
+
+	// Работает как FlatSet::InsertMany над обоими векторами: из пар пакета с равными ключами
+	// берётся первая, имеющиеся ключи не перезаписываются. Если при слиянии перемещение ключа
+	// или значения бросило исключение, словарь очищается.
+	template <typename InputIt, typename = detail::RequireInputIterator<InputIt>>
+	void InsertMany(InputIt first, InputIt last) {
+		Vector<std::pair<K, V>> items = PrepareBatch(first, last);
+		items.EraseIf([this](const std::pair<K, V>& item) {
+			return Contains(item.first);
+		});
+		if (items.Size() == 0) {
+			return;
+		}
+		index_.Clear();
+		Vector<K> batch_keys;
+		Vector<V> batch_values;
+		batch_keys.Reserve(items.Size());
+		batch_values.Reserve(items.Size());
+		for (auto& item : items) {
+			batch_keys.EmplaceBack(std::move(item.first));
+			batch_values.EmplaceBack(std::move(item.second));
+		}
+		const size_t old_size = keys_.Size();
+		const bool append_only = old_size == 0 || comp_(keys_[old_size - 1], batch_keys[0]);
+		keys_.Append(std::make_move_iterator(batch_keys.begin()), std::make_move_iterator(batch_keys.end()));
+		try {
+			values_.Append(std::make_move_iterator(batch_values.begin()), std::make_move_iterator(batch_values.end()));
+		}
+		catch (...) {
+			keys_.Erase(keys_.cbegin() + old_size, keys_.cend());
+			throw;
+		}
+		if (append_only) {
+			return;
+		}
+		try {
+			std::swap_ranges(keys_.begin() + old_size, keys_.end(), batch_keys.begin());
+			std::swap_ranges(values_.begin() + old_size, values_.end(), batch_values.begin());
+			size_t i = old_size;
+			size_t j = batch_keys.Size();
+			for (size_t out = keys_.Size(); j != 0;) {
+				--out;
+				if (i != 0 && comp_(batch_keys[j - 1], keys_[i - 1])) {
+					--i;
+					keys_[out] = std::move(keys_[i]);
+					values_[out] = std::move(values_[i]);
+				}
+				else {
+					--j;
+					keys_[out] = std::move(batch_keys[j]);
+					values_[out] = std::move(batch_values[j]);
+				}
+			}
+		}
+		catch (...) {
+			Clear();
+			throw;
+		}
+	}
+
+	void InsertMany(std::initializer_list<std::pair<K, V>> items) {
+		InsertMany(items.begin(), items.end());
+	}
+
+	size_t Erase(const K& key) {
+		const auto [pos, found] = Lookup(key);
+		if (!found) {
+			return 0;
+		}
+		Erase(begin() + pos);
+		return 1;
+	}
+
+	iterator Erase(const_iterator pos) {
+		const size_t index = pos - cbegin();
+		index_.Clear();
+		keys_.Erase(keys_.cbegin() + index);
+		values_.Erase(values_.cbegin() + index);
+		return begin() + index;
+	}
+
+	// Удаляет пары, для которых pred(key, value) истинно, за один проход: каждая оставшаяся
+	// пара перемещается не больше одного раза. Возвращает количество удалённых пар.
+	template <typename Predicate>
+	size_t EraseIf(Predicate pred) {
+		index_.Clear();
+		const size_t old_size = keys_.Size();
+		size_t out = 0;
+		size_t i = 0;
+		try {
+			for (; i < old_size; ++i) {
+				if (!pred(std::as_const(keys_[i]), values_[i])) {
+					if (out != i) {
+						keys_[out] = std::move(keys_[i]);
+						values_[out] = std::move(values_[i]);
+					}
+					++out;
+				}
+			}
+		}
+		catch (...) {
+			// Непроверенный остаток подтягивается к уже уплотнённой части
+			for (; i < old_size; ++i, ++out) {
+				keys_[out] = std::move(keys_[i]);
+				values_[out] = std::move(values_[i]);
+			}
+			Truncate(out);
+			throw;
+		}
+		Truncate(out);
+		return old_size - out;
+	}
+
+	void Clear() noexcept {
+		index_.Clear();
+		keys_.Clear();
+		values_.Clear();
+	}
+
+	void Swap(FlatMap& other) noexcept {
+		keys_.Swap(other.keys_);
+		values_.Swap(other.values_);
+		std::swap(index_, other.index_);
+		std::swap(comp_, other.comp_);
+	}
+
+private:
+	std::pair<size_t, bool> Lookup(const K& key) const {
+		return detail::FlatLookup(keys_, index_, key, comp_);
+	}
+
+	// Пары пакета, устойчиво отсортированные по ключу, без повторов ключей
+	template <typename InputIt>
+	Vector<std::pair<K, V>> PrepareBatch(InputIt first, InputIt last) const {
+		Vector<std::pair<K, V>> items;
+		items.Append(first, last);
+		const auto key_less = [this](const std::pair<K, V>& lhs, const std::pair<K, V>& rhs) {
+			return comp_(lhs.first, rhs.first);
+		};
+		std::stable_sort(items.begin(), items.end(), key_less);
+		items.Erase(std::unique(items.begin(), items.end(), [&key_less](const auto& lhs, const auto& rhs) {
+			return !key_less(lhs, rhs);
+		}), items.cend());
+		return items;
+	}
+
+	void Truncate(size_t size) noexcept {
+		keys_.Erase(keys_.cbegin() + size, keys_.cend());
+		values_.Erase(values_.cbegin() + size, values_.cend());
+	}
+
+	Vector<K> keys_;
+	Vector<V> values_;
+	detail::EytzingerIndex<K> index_;
+	[[no_unique_address]] Compare comp_;
+};
@@ -0,0 +1,376 @@
+#pragma once
+#include "vector.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Профиль кучи векторов. Если VECTOR_HEAP_PROFILE определён во всей программе, каждый буфер
+// RawMemory записывается за местом вызова, которое его выделило: методом Reserve, PushBack
+// или Resize, вызвавшим рост, или местом создания вектора. Без VECTOR_HEAP_PROFILE профиль пуст.
+// Профиль собирается через std::unordered_map и std::map под одним мьютексом и предназначен
+// только для отладочных сборок.
+
+namespace detail {
+
+// Минимальная запись сообщений protobuf для WritePprof
+class ProtoWriter {
+public:
+	void Varint(uint32_t field, uint64_t value) {
+		Tag(field, 0);
+		Raw(value);
+	}
+
+	void Bytes(uint32_t field, const std::string& value) {
+		Tag(field, 2);
+		Raw(value.size());
+		data_ += value;
+	}
+
+	void Message(uint32_t field, const ProtoWriter& message) {
+		Bytes(field, message.data_);
+	}
+
+	void Packed(uint32_t field, std::initializer_list<uint64_t> values) {
+		ProtoWriter packed;
+		for (const uint64_t value : values) {
+			packed.Raw(value);
+		}
+		Bytes(field, packed.data_);
+	}
+
+	const std::string& Data() const noexcept {
+		return data_;
+	}
+
+private:
+	void Tag(uint32_t field, uint32_t wire_type) {
+		Raw(uint64_t{ field } << 3 | wire_type);
+	}
+
+	void Raw(uint64_t value) {
+		while (value >= 0x80) {
+			data_ += static_cast<char>((value & 0x7f) | 0x80);
+			value >>= 7;
+		}
+		data_ += static_cast<char>(value);
+	}
+
+	std::string data_;
+};
+
+}  // namespace detail
+
+// Выделения одного места вызова
+struct HeapProfileSite {
+	const char* file = nullptr;      // nullptr — буфер выделен вне Vector (например, RawMemory напрямую)
+	const char* function = nullptr;
+	unsigned line = 0;
+	size_t allocations = 0;
+	size_t allocated_bytes = 0;
+	size_t reallocations = 0;        // переносы элементов в новый буфер при росте
+	size_t live_blocks = 0;
+	size_t live_bytes = 0;
+	size_t live_capacity = 0;        // суммарная вместимость живых буферов в элементах
+	size_t peak_bytes = 0;           // наибольшее значение live_bytes
+	size_t peak_capacity = 0;        // наибольшая вместимость одного буфера
+};
+
+class HeapProfiler {
+public:
+	// Профилировщик не разрушается: буферы статических векторов освобождаются после выхода из main
+	static HeapProfiler& Instance() {
+		static HeapProfiler* profiler = new HeapProfiler();
+		return *profiler;
+	}
+
+	HeapProfiler(const HeapProfiler&) = delete;
+	HeapProfiler& operator=(const HeapProfiler&) = delete;
+
+	void OnAllocate(const void* block, size_t capacity, size_t bytes, const detail::SourceSite& site) noexcept {
+		std::lock_guard guard(mutex_);
+		const std::uintptr_t address = Address(block);
+		// Блок, освобождённый в обход RawMemory, мог остаться в профиле
+		Forget(address);
+		try {
+			HeapProfileSite& entry = GetSite(site);
+			Block& record = blocks_[address];
+			record = { &entry, capacity, bytes };
+			++entry.allocations;
+			entry.allocated_bytes += bytes;
+			++entry.live_blocks;
+			AddLive(entry, capacity, bytes);
+		}
+		catch (...) {
+			// Профиль не должен менять поведение программы: выделение просто не учитывается
+			blocks_.erase(address);
+		}
+	}
+
+	void OnResize(const void* block, size_t capacity, size_t bytes) noexcept {
+		std::lock_guard guard(mutex_);
+		const auto it = blocks_.find(Address(block));
+		if (it == blocks_.end()) {
+			return;
+		}
+		Block& record = it->second;
+		RemoveLive(*record.site, record.capacity, record.bytes);
+		AddLive(*record.site, capacity, bytes);
+		record.capacity = capacity;
+		record.bytes = bytes;
+	}
+
+	// Адрес передаётся числом: блок по нему уже может быть освобождён
+	void OnDeallocate(std::uintptr_t address) noexcept {
+		std::lock_guard guard(mutex_);
+		Forget(address);
+	}
+
+	void OnReallocate(const void* block) noexcept {
+		std::lock_guard guard(mutex_);
+		const auto it = blocks_.find(Address(block));
+		if (it != blocks_.end()) {
+			++it->second.site->reallocations;
+		}
+	}
+
+	// Места вызова по убыванию пикового объёма памяти
+	std::vector<HeapProfileSite> Snapshot() const {
+		std::vector<HeapProfileSite> result;
+		{
+			std::lock_guard guard(mutex_);
+			result.reserve(sites_.size());
+			for (const auto& [key, entry] : sites_) {
+				result.push_back(entry);
+			}
+		}
+		std::stable_sort(result.begin(), result.end(), [](const HeapProfileSite& lhs, const HeapProfileSite& rhs) {
+			if (lhs.peak_bytes != rhs.peak_bytes) {
+				return lhs.peak_bytes > rhs.peak_bytes;
+			}
+			return lhs.allocated_bytes > rhs.allocated_bytes;
+		});
+		return result;
+	}
+
+	// Обнуляет счётчики; живые буферы остаются в профиле, и пик начинается с их объёма
+	void Reset() {
+		std::lock_guard guard(mutex_);
+		for (auto it = sites_.begin(); it != sites_.end();) {
+			HeapProfileSite& entry = it->second;
+			if (entry.live_blocks == 0) {
+				it = sites_.erase(it);
+				continue;
+			}
+			entry.allocations = 0;
+			entry.allocated_bytes = 0;
+			entry.reallocations = 0;
+			entry.peak_bytes = entry.live_bytes;
+			entry.peak_capacity = 0;
+			++it;
+		}
+		for (const auto& [block, record] : blocks_) {
+			record.site->peak_capacity = std::max(record.site->peak_capacity, record.capacity);
+		}
+	}
+
+	// Таблица мест вызова по убыванию пика. Места с частыми переносами и большим запасом
+	// вместимости — кандидаты на Reserve или другую политику роста.
+	void WriteReport(std::ostream& out) const {
+		const std::vector<HeapProfileSite> sites = Snapshot();
+		out << std::setw(14) << "peak bytes" << std::setw(14) << "live bytes"
+			<< std::setw(14) << "allocated" << std::setw(8) << "allocs"
+			<< std::setw(9) << "reallocs" << std::setw(14) << "peak capacity" << "  site\n";
+		for (const HeapProfileSite& site : sites) {
+			out << std::setw(14) << site.peak_bytes << std::setw(14) << site.live_bytes
+				<< std::setw(14) << site.allocated_bytes << std::setw(8) << site.allocations
+				<< std::setw(9) << site.reallocations << std::setw(14) << site.peak_capacity
+				<< "  " << FileName(site) << ':' << site.line << ' ' << FunctionName(site) << '\n';
+		}
+	}
+
+	// Профиль в формате pprof (profile.proto без сжатия): каждое место вызова — отдельный
+	// адрес с функцией, файлом и строкой. Открывается командой pprof -top -lines <файл>.
+	void WritePprof(std::ostream& out) const {
+		const std::vector<HeapProfileSite> sites = Snapshot();
+		std::map<std::string, uint64_t> string_ids;
+		std::vector<std::string> strings;
+		auto intern = [&](const std::string& value) {
+			const auto [it, inserted] = string_ids.try_emplace(value, strings.size());
+			if (inserted) {
+				strings.push_back(value);
+			}
+			return it->second;
+		};
+		intern("");
+
+		detail::ProtoWriter profile;
+		static constexpr const char* SAMPLE_TYPES[][2] = {
+			{ "alloc_objects", "count" },
+			{ "alloc_space", "bytes" },
+			{ "inuse_objects", "count" },
+			{ "inuse_space", "bytes" },
+			{ "peak_space", "bytes" },
+			{ "reallocations", "count" },
+		};
+		for (const auto& [type, unit] : SAMPLE_TYPES) {
+			detail::ProtoWriter value_type;
+			value_type.Varint(1, intern(type));
+			value_type.Varint(2, intern(unit));
+			profile.Message(1, value_type);
+		}
+		for (size_t i = 0; i < sites.size(); ++i) {
+			const HeapProfileSite& site = sites[i];
+			const uint64_t id = i + 1;
+
+			detail::ProtoWriter sample;
+			sample.Packed(1, { id });
+			sample.Packed(2, { site.allocations, site.allocated_bytes, site.live_blocks, site.live_bytes,
+				site.peak_bytes, site.reallocations });
+			profile.Message(2, sample);
+
+			detail::ProtoWriter line;
+			line.Varint(1, id);
+			line.Varint(2, site.line);
+			detail::ProtoWriter location;
+			location.Varint(1, id);
+			location.Message(4, line);
+			profile.Message(4, location);
+
+			const uint64_t name = intern(FunctionName(site));
+			detail::ProtoWriter function;
+			function.Varint(1, id);
+			function.Varint(2, name);
+			function.Varint(3, name);
+			function.Varint(4, intern(FileName(site)));
+			profile.Message(5, function);
+		}
+		for (const std::string& value : strings) {
+			profile.Bytes(6, value);
+		}
+		profile.Varint(14, string_ids.at("inuse_space"));
+		out << profile.Data();
+	}
+
+private:
+	struct SiteKey {
+		const char* file;
+		const char* function;
+		unsigned line;
+
+		// Строки сравниваются по содержимому: одно место в заголовке может попасть
+		// в разные единицы трансляции с разными указателями на имя файла
+		bool operator<(const SiteKey& other) const noexcept {
+			if (line != other.line) {
+				return line < other.line;
+			}
+			const int by_file = std::strcmp(OrEmpty(file), OrEmpty(other.file));
+			if (by_file != 0) {
+				return by_file < 0;
+			}
+			return std::strcmp(OrEmpty(function), OrEmpty(other.function)) < 0;
+		}
+	};
+
+	struct Block {
+		HeapProfileSite* site;
+		size_t capacity;
+		size_t bytes;
+	};
+
+	HeapProfiler() = default;
+
+	static const char* OrEmpty(const char* value) noexcept {
+		return value != nullptr ? value : "";
+	}
+
+	static std::string FileName(const HeapProfileSite& site) {
+		return site.file != nullptr ? site.file : "<unknown>";
+	}
+
+	static std::string FunctionName(const HeapProfileSite& site) {
+		return site.function != nullptr ? site.function : "<unknown>";
+	}
+
+	HeapProfileSite& GetSite(const detail::SourceSite& site) {
+#ifdef VECTOR_HEAP_PROFILE
+		const SiteKey key{ site.file, site.function, site.line };
+#else
+		static_cast<void>(site);
+		const SiteKey key{ nullptr, nullptr, 0 };
+#endif
+		const auto [it, inserted] = sites_.try_emplace(key);
+		if (inserted) {
+			it->second.file = key.file;
+			it->second.function = key.function;
+			it->second.line = key.line;
+		}
+		return it->second;
+	}
+
+	static void AddLive(HeapProfileSite& site, size_t capacity, size_t bytes) noexcept {
+		site.live_bytes += bytes;
+		site.live_capacity += capacity;
+		site.peak_bytes = std::max(site.peak_bytes, site.live_bytes);
+		site.peak_capacity = std::max(site.peak_capacity, capacity);
+	}
+
+	static void RemoveLive(HeapProfileSite& site, size_t capacity, size_t bytes) noexcept {
+		site.live_bytes -= bytes;
+		site.live_capacity -= capacity;
+	}
+
+	static std::uintptr_t Address(const void* block) noexcept {
+		return reinterpret_cast<std::uintptr_t>(block);
+	}
+
+	void Forget(std::uintptr_t address) noexcept {
+		const auto it = blocks_.find(address);
+		if (it == blocks_.end()) {
+			return;
+		}
+		const Block& record = it->second;
+		RemoveLive(*record.site, record.capacity, record.bytes);
+		--record.site->live_blocks;
+		blocks_.erase(it);
+	}
+
+	mutable std::mutex mutex_;
+	std::map<SiteKey, HeapProfileSite> sites_;
+	std::unordered_map<std::uintptr_t, Block> blocks_;
+};
+
+namespace detail {
+
+#ifdef VECTOR_HEAP_PROFILE
+inline SourceSite& CurrentSite() noexcept {
+	thread_local SourceSite site;
+	return site;
+}
+
+inline void HeapProfileAllocate(const void* block, size_t capacity, size_t bytes) noexcept {
+	HeapProfiler::Instance().OnAllocate(block, capacity, bytes, CurrentSite());
+}
+
+inline void HeapProfileResize(const void* block, size_t capacity, size_t bytes) noexcept {
+	HeapProfiler::Instance().OnResize(block, capacity, bytes);
+}
+
+inline void HeapProfileDeallocate(std::uintptr_t address) noexcept {
+	HeapProfiler::Instance().OnDeallocate(address);
+}
+
+inline void HeapProfileReallocate(const void* block) noexcept {
+	HeapProfiler::Instance().OnReallocate(block);
+}
+#endif
+
+}  // namespace detail
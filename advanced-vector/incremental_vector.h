@@ -0,0 +1,371 @@
+#pragma once
+#include "vector.h"
+
+#include <cassert>
+#include <iterator>
+#include <utility>
+
+// Вектор с постепенной реаллокацией. Когда буфер заполнен, выделяется новый буфер,
+// а элементы переносятся в него не сразу, а по нескольку (не меньше MigrationStep)
+// при каждом следующем добавлении, как при постепенном изменении размера хеш-таблицы.
+// Поэтому EmplaceBack никогда не переносит все элементы за один вызов.
+//
+// Пока идёт перенос, элементы лежат в двух буферах: operator[] и итераторы выбирают буфер
+// по индексу, а Data() завершает перенос и возвращает непрерывный массив. Любое добавление
+// может переместить элементы, поэтому ссылки и указатели на элементы становятся
+// недействительными; итераторы хранят индекс и остаются действительными.
+template <typename T, typename Growth = DoublingGrowth, size_t MigrationStep = 2>
+class IncrementalVector {
+	static_assert(MigrationStep > 0);
+
+public:
+	template <bool Const>
+	class Iterator {
+		using Owner = std::conditional_t<Const, const IncrementalVector, IncrementalVector>;
+
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using reference = std::conditional_t<Const, const T&, T&>;
+		using pointer = std::conditional_t<Const, const T*, T*>;
+
+		Iterator() = default;
+
+		Iterator(Owner& owner, size_t index) noexcept
+			: owner_(&owner)
+			, index_(index) {
+		}
+
+		operator Iterator<true>() const noexcept {
+			return Iterator<true>(*owner_, index_);
+		}
+
+		reference operator*() const noexcept {
+			return (*owner_)[index_];
+		}
+		pointer operator->() const noexcept {
+			return &(*owner_)[index_];
+		}
+		reference operator[](difference_type n) const noexcept {
+			return (*owner_)[index_ + n];
+		}
+		Iterator& operator++() noexcept {
+			++index_;
+			return *this;
+		}
+		Iterator operator++(int) noexcept {
+			Iterator old = *this;
+			++index_;
+			return old;
+		}
+		Iterator& operator--() noexcept {
+			--index_;
+			return *this;
+		}
+		Iterator operator--(int) noexcept {
+			Iterator old = *this;
+			--index_;
+			return old;
+		}
+		Iterator& operator+=(difference_type n) noexcept {
+			index_ += n;
+			return *this;
+		}
+		Iterator& operator-=(difference_type n) noexcept {
+			index_ -= n;
+			return *this;
+		}
+		Iterator operator+(difference_type n) const noexcept {
+			return Iterator(*owner_, index_ + n);
+		}
+		Iterator operator-(difference_type n) const noexcept {
+			return Iterator(*owner_, index_ - n);
+		}
+		friend Iterator operator+(difference_type n, const Iterator& it) noexcept {
+			return it + n;
+		}
+
+		// Сравнения и разность принимают и iterator, и const_iterator
+		template <bool C>
+		difference_type operator-(const Iterator<C>& other) const noexcept {
+			return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_);
+		}
+		template <bool C>
+		bool operator==(const Iterator<C>& other) const noexcept {
+			return index_ == other.index_;
+		}
+		template <bool C>
+		bool operator!=(const Iterator<C>& other) const noexcept {
+			return index_ != other.index_;
+		}
+		template <bool C>
+		bool operator<(const Iterator<C>& other) const noexcept {
+			return index_ < other.index_;
+		}
+		template <bool C>
+		bool operator>(const Iterator<C>& other) const noexcept {
+			return index_ > other.index_;
+		}
+		template <bool C>
+		bool operator<=(const Iterator<C>& other) const noexcept {
+			return index_ <= other.index_;
+		}
+		template <bool C>
+		bool operator>=(const Iterator<C>& other) const noexcept {
+			return index_ >= other.index_;
+		}
+
+	private:
+		template <bool C>
+		friend class Iterator;
+
+		Owner* owner_ = nullptr;
+		size_t index_ = 0;
+	};
+
+	using iterator = Iterator<false>;
+	using const_iterator = Iterator<true>;
+
+	IncrementalVector() = default;
+
+	// Деструктор не вызывается, если конструктор выбросил исключение: созданные элементы
+	// разрушаются здесь, а буферы освобождают деструкторы полей RawMemory
+	explicit IncrementalVector(size_t size) {
+		try {
+			Resize(size);
+		}
+		catch (...) {
+			Clear();
+			throw;
+		}
+	}
+
+	IncrementalVector(const IncrementalVector& other)
+		: memory_(other.size_) {
+		try {
+			for (; size_ < other.size_; ++size_) {
+				new(memory_ + size_) T(other[size_]);
+			}
+		}
+		catch (...) {
+			Clear();
+			throw;
+		}
+	}
+
+	IncrementalVector(IncrementalVector&& other) noexcept {
+		Swap(other);
+	}
+
+	IncrementalVector& operator=(const IncrementalVector& rhs) {
+		if (this != &rhs) {
+			IncrementalVector copy(rhs);
+			Swap(copy);
+		}
+		return *this;
+	}
+
+	IncrementalVector& operator=(IncrementalVector&& rhs) noexcept {
+		if (this != &rhs) {
+			IncrementalVector empty;
+			Swap(empty);
+			Swap(rhs);
+		}
+		return *this;
+	}
+
+	~IncrementalVector() {
+		Clear();
+	}
+
+	iterator begin() noexcept {
+		return iterator(*this, 0);
+	}
+	iterator end() noexcept {
+		return iterator(*this, size_);
+	}
+	const_iterator begin() const noexcept {
+		return const_iterator(*this, 0);
+	}
+	const_iterator end() const noexcept {
+		return const_iterator(*this, size_);
+	}
+	const_iterator cbegin() const noexcept {
+		return begin();
+	}
+	const_iterator cend() const noexcept {
+		return end();
+	}
+
+	size_t Size() const noexcept {
+		return size_;
+	}
+
+	size_t Capacity() const noexcept {
+		return IsMigrating() ? next_.Capacity() : memory_.Capacity();
+	}
+
+	// Ещё не перенесённые в новый буфер элементы
+	size_t PendingMigration() const noexcept {
+		return pending_;
+	}
+
+	bool IsMigrating() const noexcept {
+		return pending_ != 0;
+	}
+
+	const T& operator[](size_t index) const noexcept {
+		return const_cast<IncrementalVector&>(*this)[index];
+	}
+
+	T& operator[](size_t index) noexcept {
+		assert(index < size_);
+		return *Slot(index);
+	}
+
+	// Завершает перенос, если он идёт (O(n)), и возвращает непрерывный массив элементов
+	T* Data() {
+		FinishMigration();
+		return memory_.GetAddress();
+	}
+
+	// В отличие от роста при добавлении, переносит все элементы сразу
+	void Reserve(size_t capacity) {
+		if (capacity <= Capacity()) {
+			return;
+		}
+		FinishMigration();
+		RawMemory<T> new_data(capacity);
+		detail::UninitializedRelocate(memory_.GetAddress(), size_, new_data.GetAddress());
+		detail::DestroyRelocated(memory_.GetAddress(), size_);
+		memory_.Swap(new_data);
+	}
+
+	void Resize(size_t new_size) {
+		while (size_ > new_size) {
+			PopBack();
+		}
+		while (size_ < new_size) {
+			EmplaceBack();
+		}
+	}
+
+	// Переносит не больше нескольких элементов. При исключении вектор не изменяется.
+	template <typename... Args>
+	T& EmplaceBack(Args&&... args) {
+		if (!IsMigrating() && size_ == memory_.Capacity()) {
+			StartMigration();
+		}
+		T* elem = new(Slot(size_)) T(std::forward<Args>(args)...);
+		if (IsMigrating()) {
+			// Новый элемент создан до переноса: аргументы могли ссылаться на переносимые элементы
+			try {
+				MigrateSome();
+			}
+			catch (...) {
+				std::destroy_at(elem);
+				throw;
+			}
+		}
+		++size_;
+		return *elem;
+	}
+
+	void PushBack(const T& value) {
+		EmplaceBack(value);
+	}
+
+	void PushBack(T&& value) {
+		EmplaceBack(std::move(value));
+	}
+
+	void PopBack() noexcept {
+		assert(size_ != 0);
+		--size_;
+		std::destroy_at(Slot(size_));
+		if (IsMigrating() && size_ == migrated_ + pending_ - 1) {
+			// Удалён последний ещё не перенесённый элемент
+			if (--pending_ == 0) {
+				CompleteMigration();
+			}
+		}
+	}
+
+	void Clear() noexcept {
+		for (size_t i = 0; i < size_; ++i) {
+			std::destroy_at(Slot(i));
+		}
+		size_ = 0;
+		if (IsMigrating()) {
+			pending_ = 0;
+			CompleteMigration();
+		}
+	}
+
+	void Swap(IncrementalVector& other) noexcept {
+		memory_.Swap(other.memory_);
+		next_.Swap(other.next_);
+		std::swap(size_, other.size_);
+		std::swap(migrated_, other.migrated_);
+		std::swap(pending_, other.pending_);
+	}
+
+private:
+	// Элементы [migrated_, migrated_ + pending_) ещё в memory_, остальные — в next_
+	T* Slot(size_t index) noexcept {
+		if (IsMigrating() && (index < migrated_ || index >= migrated_ + pending_)) {
+			return next_ + index;
+		}
+		return memory_ + index;
+	}
+
+	void StartMigration() {
+		RawMemory<T> next(Growth::NextCapacity(memory_.Capacity(), sizeof(T)));
+		if (size_ == 0) {
+			memory_.Swap(next);
+			return;
+		}
+		next_.Swap(next);
+		migrated_ = 0;
+		pending_ = size_;
+	}
+
+	// Переносит столько элементов, чтобы перенос закончился раньше, чем заполнится next_
+	void MigrateSome() {
+		const size_t pushes_left = next_.Capacity() - size_;
+		size_t count = std::max(MigrationStep, (pending_ + pushes_left - 1) / pushes_left);
+		while (count-- > 0 && IsMigrating()) {
+			MigrateOne();
+		}
+	}
+
+	void FinishMigration() {
+		while (IsMigrating()) {
+			MigrateOne();
+		}
+	}
+
+	// При исключении элемент остаётся в старом буфере
+	void MigrateOne() {
+		T* from = memory_ + migrated_;
+		detail::UninitializedRelocate(from, 1, next_ + migrated_);
+		detail::DestroyRelocated(from, 1);
+		++migrated_;
+		if (--pending_ == 0) {
+			CompleteMigration();
+		}
+	}
+
+	void CompleteMigration() noexcept {
+		memory_.Swap(next_);
+		next_ = RawMemory<T>();
+		migrated_ = 0;
+	}
+
+	RawMemory<T> memory_;
+	RawMemory<T> next_;
+	size_t size_ = 0;
+	size_t migrated_ = 0;
+	size_t pending_ = 0;
+};
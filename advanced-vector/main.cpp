@@ -1,8 +1,27 @@
 #include "vector.h"
+#include "arena_vector.h"
+#include "chunked_vector.h"
+#include "concurrent_vector.h"
+#include "cow_vector.h"
+#include "flat_map.h"
+#include "heap_profile.h"
+#include "incremental_vector.h"
+#include "mapped_vector.h"
+#include "parallel_algorithms.h"
+#include "placement_allocator.h"
+#include "serialization.h"
+#include "soa_vector.h"
 
+#include <atomic>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace {
@@ -116,8 +135,255 @@ namespace {
         static inline int num_move_assigned = 0;
     };
 
+    // Тип с нетривиальными конструкторами, который разрешено переносить побитово
+    struct Handle {
+        Handle() = default;
+        explicit Handle(int id)
+            : id(id) {
+        }
+        Handle(const Handle& other)
+            : id(other.id) {
+            ++num_copied;
+        }
+        Handle(Handle&& other) noexcept
+            : id(other.id) {
+            ++num_moved;
+        }
+        ~Handle() {
+            ++num_destroyed;
+        }
+
+        static void ResetCounters() {
+            num_copied = 0;
+            num_moved = 0;
+            num_destroyed = 0;
+        }
+
+        int id = 0;
+
+        static inline int num_copied = 0;
+        static inline int num_moved = 0;
+        static inline int num_destroyed = 0;
+    };
+
+    struct AllocStats {
+        int allocations = 0;
+        int live_blocks = 0;
+    };
+
+    // Аллокатор с состоянием: разные id считаются неравными
+    template <typename T, bool Propagate>
+    struct TaggedAllocator {
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::bool_constant<Propagate>;
+        using propagate_on_container_move_assignment = std::bool_constant<Propagate>;
+        using propagate_on_container_swap = std::bool_constant<Propagate>;
+        using is_always_equal = std::false_type;
+
+        TaggedAllocator(int id, AllocStats* stats)
+            : id(id)
+            , stats(stats) {
+        }
+
+        template <typename U>
+        TaggedAllocator(const TaggedAllocator<U, Propagate>& other) noexcept
+            : id(other.id)
+            , stats(other.stats) {
+        }
+
+        T* allocate(size_t n) {
+            ++stats->allocations;
+            ++stats->live_blocks;
+            return std::allocator<T>().allocate(n);
+        }
+
+        void deallocate(T* p, size_t n) noexcept {
+            --stats->live_blocks;
+            std::allocator<T>().deallocate(p, n);
+        }
+
+        bool operator==(const TaggedAllocator& other) const noexcept {
+            return id == other.id;
+        }
+        bool operator!=(const TaggedAllocator& other) const noexcept {
+            return id != other.id;
+        }
+
+        int id;
+        AllocStats* stats;
+    };
+
+    // Аллокатор, округляющий размер блока вверх до кратного 8 элементам
+    template <typename T>
+    struct RoundingAllocator {
+        using value_type = T;
+
+        struct Result {
+            T* ptr;
+            size_t count;
+        };
+
+        RoundingAllocator() = default;
+        template <typename U>
+        RoundingAllocator(const RoundingAllocator<U>&) noexcept {
+        }
+
+        Result allocate_at_least(size_t n) {
+            const size_t count = (n + 7) / 8 * 8;
+            return { allocate(count), count };
+        }
+        T* allocate(size_t n) {
+            return std::allocator<T>().allocate(n);
+        }
+        void deallocate(T* p, size_t n) noexcept {
+            std::allocator<T>().deallocate(p, n);
+        }
+
+        bool operator==(const RoundingAllocator&) const noexcept {
+            return true;
+        }
+        bool operator!=(const RoundingAllocator&) const noexcept {
+            return false;
+        }
+    };
+
+    // Выделяет память последовательно из одного региона и умеет расширять последний блок
+    template <typename T>
+    struct ExpandingAllocator {
+        using value_type = T;
+
+        struct Region {
+            alignas(std::max_align_t) unsigned char bytes[1 << 16];
+            size_t used = 0;
+            int expansions = 0;
+        };
+
+        explicit ExpandingAllocator(Region* region)
+            : region(region) {
+        }
+
+        T* allocate(size_t n) {
+            if (region->used + n * sizeof(T) > sizeof(region->bytes)) {
+                throw std::bad_alloc();
+            }
+            T* p = reinterpret_cast<T*>(region->bytes + region->used);
+            region->used += n * sizeof(T);
+            return p;
+        }
+
+        void deallocate(T* /*p*/, size_t /*n*/) noexcept {
+        }
+
+        bool try_expand(T* p, size_t old_n, size_t new_n) noexcept {
+            unsigned char* end = reinterpret_cast<unsigned char*>(p + old_n);
+            if (end != region->bytes + region->used
+                || region->used + (new_n - old_n) * sizeof(T) > sizeof(region->bytes)) {
+                return false;
+            }
+            region->used += (new_n - old_n) * sizeof(T);
+            ++region->expansions;
+            return true;
+        }
+
+        bool operator==(const ExpandingAllocator& other) const noexcept {
+            return region == other.region;
+        }
+        bool operator!=(const ExpandingAllocator& other) const noexcept {
+            return region != other.region;
+        }
+
+        Region* region;
+    };
+
+    // Перемещение может выбросить исключение, поэтому при реаллокации элементы копируются
+    struct MaybeThrowingMove {
+        MaybeThrowingMove() = default;
+        MaybeThrowingMove(const MaybeThrowingMove&) = default;
+        MaybeThrowingMove(MaybeThrowingMove&&) {
+        }
+        MaybeThrowingMove& operator=(const MaybeThrowingMove&) = default;
+    };
+
+    // Конструируется из int без исключений
+    struct NothrowObj {
+        explicit NothrowObj(int id) noexcept
+            : id(id) {
+        }
+        NothrowObj(NothrowObj&& other) noexcept
+            : id(other.id) {
+            ++num_moved;
+        }
+        NothrowObj& operator=(NothrowObj&& other) noexcept {
+            id = other.id;
+            ++num_move_assigned;
+            return *this;
+        }
+
+        int id;
+
+        static inline int num_moved = 0;
+        static inline int num_move_assigned = 0;
+    };
+
+    struct IngestTag {
+        static constexpr const char* NAME = "ingest";
+    };
+
+    // Счётчики атомарны: объекты создаются и разрушаются в нескольких потоках
+    struct SharedObj {
+        SharedObj() {
+            if (default_construction_throw_countdown.fetch_sub(1) == 1) {
+                throw std::runtime_error("Oops");
+            }
+            ++num_alive;
+        }
+
+        SharedObj(const SharedObj& other)
+            : id(other.id) {
+            if (other.throw_on_copy) {
+                throw std::runtime_error("Oops");
+            }
+            ++num_alive;
+        }
+
+        SharedObj& operator=(const SharedObj& other) = default;
+
+        ~SharedObj() {
+            --num_alive;
+        }
+
+        static void ResetCounters() {
+            default_construction_throw_countdown = 0;
+            num_alive = 0;
+        }
+
+        bool throw_on_copy = false;
+        int id = 0;
+
+        static inline std::atomic<long> default_construction_throw_countdown{ 0 };
+        static inline std::atomic<int> num_alive{ 0 };
+    };
+
+    struct Pixel {
+        float r, g, b, a;
+    };
+
 }  // namespace
 
+// Буферы пикселей от 1 МиБ чередуются по узлам NUMA
+template <>
+struct DefaultPlacement<Pixel> {
+    static constexpr Placement VALUE{ 1 << 20, NumaPolicy::INTERLEAVE, 0 };
+};
+
+template <>
+struct IsTriviallyRelocatable<Handle> : std::true_type {
+};
+
+template <typename U>
+struct IsTriviallyRelocatable<std::unique_ptr<U>> : std::true_type {
+};
+
 void Test1() {
     Obj::ResetCounters();
     const size_t SIZE = 100500;
@@ -561,89 +827,2235 @@ void Test6() {
         assert(Obj::num_moved == 0);
         assert(Obj::GetAliveObjectCount() == SIZE - 1);
     }
-}
+    // Вставка без реаллокации: число копирований и перемещений на одну вставку
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v{ SIZE };
+        v.Reserve(SIZE * 2);
+        const int old_num_moved = Obj::num_moved;
+        v.Emplace(v.cend(), ID, "Ivan"s);
+        assert(Obj::num_moved == old_num_moved);
+        assert(Obj::num_move_assigned == 0);
+        assert(v[SIZE].id == ID);
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v{ SIZE };
+        v.Reserve(SIZE * 2);
+        const int old_num_moved = Obj::num_moved;
+        const Obj obj(ID);
+        // Копирующее присваивание Obj может бросить исключение: копия создаётся до сдвига
+        v.Insert(v.cbegin() + 3, obj);
+        assert(Obj::num_copied == 1);
+        assert(Obj::num_assigned == 0);
+        assert(Obj::num_moved == old_num_moved + 1);
+        assert(Obj::num_move_assigned == SIZE - 3);
+        assert(v[3].id == ID);
 
-struct C {
-    C() noexcept {
-        ++def_ctor;
+        // Перемещающее присваивание noexcept: аргумент присваивается на место без временного объекта
+        Obj other(ID + 1);
+        v.Insert(v.cbegin() + 3, std::move(other));
+        assert(Obj::num_moved == old_num_moved + 2);
+        assert(Obj::num_move_assigned == (SIZE - 3) + (SIZE - 2));
+        assert(v[3].id == ID + 1 && v[4].id == ID);
     }
-    C(const C& /*other*/) noexcept {
-        ++copy_ctor;
+    {
+        struct Throwing {
+            explicit Throwing(int id)
+                : id(id) {
+            }
+            Throwing(const Throwing& other)
+                : id(other.id) {
+                if (other.throw_on_copy) {
+                    throw std::runtime_error("copy");
+                }
+            }
+            Throwing(Throwing&&) noexcept = default;
+            Throwing& operator=(const Throwing& other) {
+                if (other.throw_on_copy) {
+                    throw std::runtime_error("copy");
+                }
+                id = other.id;
+                return *this;
+            }
+            Throwing& operator=(Throwing&&) noexcept = default;
+            int id;
+            bool throw_on_copy = false;
+        };
+        Vector<Throwing> v;
+        v.Reserve(SIZE * 2);
+        for (int i = 0; i < static_cast<int>(SIZE); ++i) {
+            v.EmplaceBack(i);
+        }
+        Throwing bad(-1);
+        bad.throw_on_copy = true;
+        try {
+            v.Insert(v.cbegin() + 3, bad);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        // Строгая гарантия: ни сдвига, ни перемещённых элементов
+        assert(v.Size() == SIZE);
+        for (int i = 0; i < static_cast<int>(SIZE); ++i) {
+            assert(v[i].id == i);
+        }
     }
-    C(C&& /*other*/) noexcept {
-        ++move_ctor;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v{ SIZE };
+        v.Reserve(SIZE * 2);
+        v[0].id = ID;
+        const int old_num_moved = Obj::num_moved;
+        // Аргумент ссылается на элемент вектора: сначала создаётся копия
+        v.Insert(v.cbegin() + 3, v[0]);
+        assert(Obj::num_copied == 1);
+        assert(Obj::num_assigned == 0);
+        assert(Obj::num_moved == old_num_moved + 1);
+        assert(Obj::num_move_assigned == SIZE - 3);
+        assert(v[3].id == ID);
     }
-    C& operator=(const C& other) noexcept {
-        if (this != &other) {
-            ++copy_assign;
+    {
+        Vector<NothrowObj> v;
+        v.Reserve(SIZE);
+        for (int i = 0; i < static_cast<int>(SIZE) - 1; ++i) {
+            v.EmplaceBack(i);
         }
-        return *this;
+        assert(NothrowObj::num_moved == 0);
+        // Конструктор noexcept из скалярного аргумента: элемент пересоздаётся на месте
+        v.Emplace(v.cbegin() + 1, ID);
+        assert(NothrowObj::num_moved == 1);
+        assert(NothrowObj::num_move_assigned == static_cast<int>(SIZE) - 3);
+        assert(v[1].id == ID && v[2].id == 1);
+        // Аргумент ссылается на поле элемента: значение читается до сдвига
+        v.Reserve(SIZE * 2);
+        v.Emplace(v.cbegin(), v[1].id);
+        assert(v[0].id == ID && v[2].id == ID);
     }
-    C& operator=(C&& /*other*/) noexcept {
-        ++move_assign;
-        return *this;
+}
+
+void Test7() {
+    const size_t SIZE = 100;
+    {
+        Handle::ResetCounters();
+        Vector<Handle> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(static_cast<int>(i));
+        }
+        v.Reserve(SIZE * 4);
+        v.Emplace(v.cbegin() + SIZE / 2, -1);
+        assert(v.Size() == SIZE + 1);
+        assert(v[SIZE / 2].id == -1);
+        assert(v[SIZE].id == static_cast<int>(SIZE) - 1);
+        // Перенос при реаллокации выполняется побитово
+        assert(Handle::num_copied == 0);
+        assert(Handle::num_moved == 0);
+        assert(Handle::num_destroyed == 0);
+
+        Handle::ResetCounters();
+        v.Erase(v.cbegin() + SIZE / 2);
+        assert(v.Size() == SIZE);
+        assert(Handle::num_moved == 0);
+        assert(Handle::num_destroyed == 1);
+        for (size_t i = 0; i < SIZE; ++i) {
+            assert(v[i].id == static_cast<int>(i));
+        }
     }
-    ~C() {
-        ++dtor;
+    {
+        Vector<std::unique_ptr<int>> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack(std::make_unique<int>(static_cast<int>(i)));
+        }
+        v.Erase(v.cbegin());
+        assert(v.Size() == SIZE - 1);
+        for (size_t i = 0; i + 1 < SIZE; ++i) {
+            assert(*v[i] == static_cast<int>(i) + 1);
+        }
     }
+}
 
-    static void Reset() {
-        def_ctor = 0;
-        copy_ctor = 0;
-        move_ctor = 0;
-        copy_assign = 0;
-        move_assign = 0;
-        dtor = 0;
-    }
+void Test8() {
+    const size_t SIZE = 10;
+    {
+        using Alloc = TaggedAllocator<Obj, true>;
+        AllocStats stats1, stats2;
+        Obj::ResetCounters();
+        {
+            Vector<Obj, Alloc> v1(SIZE, Alloc(1, &stats1));
+            Vector<Obj, Alloc> v2(SIZE * 2, Alloc(2, &stats2));
+            v2[0].id = 42;
+            v1 = v2;
+            assert(v1.GetAllocator().id == 2);
+            assert(v1.Size() == SIZE * 2);
+            assert(v1[0].id == 42);
+            assert(stats1.live_blocks == 0);
+            assert(stats2.live_blocks == 2);
 
-    inline static size_t def_ctor = 0;
-    inline static size_t copy_ctor = 0;
-    inline static size_t move_ctor = 0;
-    inline static size_t copy_assign = 0;
-    inline static size_t move_assign = 0;
-    inline static size_t dtor = 0;
-};
+            Vector<Obj, Alloc> v3(SIZE, Alloc(3, &stats1));
+            v3 = std::move(v1);
+            assert(v3.GetAllocator().id == 2);
+            assert(v3[0].id == 42);
+            v3.Swap(v1);
+            assert(v1.GetAllocator().id == 2);
+            assert(v3.GetAllocator().id == 3);
+        }
+        assert(stats1.live_blocks == 0);
+        assert(stats2.live_blocks == 0);
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        using Alloc = TaggedAllocator<Obj, false>;
+        AllocStats stats1, stats2;
+        Obj::ResetCounters();
+        {
+            Vector<Obj, Alloc> v1(SIZE, Alloc(1, &stats1));
+            Vector<Obj, Alloc> v2(SIZE * 2, Alloc(2, &stats2));
+            v1 = v2;
+            assert(v1.GetAllocator().id == 1);
+            assert(v1.Size() == SIZE * 2);
+            assert(stats1.live_blocks == 1);
 
-void Dump() {
-    using namespace std;
-    cerr << "Def ctors: "sv << C::def_ctor              //
-        << ", Copy ctors: "sv << C::copy_ctor          //
-        << ", Move ctors: "sv << C::move_ctor          //
-        << ", Copy assignments: "sv << C::copy_assign  //
-        << ", Move assignments: "sv << C::move_assign  //
-        << ", Dtors: "sv << C::dtor << endl;
+            const int old_num_moved = Obj::num_moved;
+            v1 = std::move(v2);
+            // Аллокаторы не равны, поэтому элементы перемещаются в память v1
+            assert(v1.GetAllocator().id == 1);
+            assert(Obj::num_moved == old_num_moved + static_cast<int>(SIZE) * 2);
+            assert(stats1.live_blocks == 1);
+            assert(stats2.live_blocks == 1);
+        }
+        assert(stats1.live_blocks == 0);
+        assert(stats2.live_blocks == 0);
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        Vector<int, RoundingAllocator<int>> v;
+        v.Reserve(5);
+        assert(v.Capacity() == 8);
+        for (int i = 0; i < 9; ++i) {
+            v.PushBack(i);
+        }
+        assert(v.Size() == 9);
+        assert(v.Capacity() == 16);
+    }
 }
 
-void Benchmark() {
-    using namespace std;
-    try {
-        const size_t NUM = 10;
-        C c;
-        {
-            cerr << "std::vector:"sv << endl;
-            C::Reset();
-            vector<C> v(NUM);
-            Dump();
-            v.push_back(c);
+void Test9() {
+    const size_t SIZE = 1000;
+    {
+        Vector<int, MallocAllocator<int>> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack(static_cast<int>(i));
         }
-        Dump();
+        v.Emplace(v.cbegin() + 1, -1);
+        assert(v.Size() == SIZE + 1);
+        assert(v[0] == 0 && v[1] == -1 && v[2] == 1);
+        assert(v[SIZE] == static_cast<int>(SIZE) - 1);
+
+        v.Reserve(SIZE * 10);
+        assert(v.Capacity() == SIZE * 10);
+        assert(v[SIZE] == static_cast<int>(SIZE) - 1);
+
+        Vector<int, MallocAllocator<int>> small(1);
+        small[0] = 7;
+        // Аргумент ссылается на элемент вектора, блок которого переезжает через realloc
+        small.PushBack(small[0]);
+        small.Emplace(small.cbegin(), small[1]);
+        assert(small.Size() == 3);
+        assert(small[0] == 7 && small[1] == 7 && small[2] == 7);
     }
-    catch (...) {
+    {
+        Handle::ResetCounters();
+        Vector<Handle, MallocAllocator<Handle>> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(static_cast<int>(i));
+        }
+        assert(Handle::num_moved == 0);
+        assert(Handle::num_copied == 0);
+        assert(Handle::num_destroyed == 0);
+        for (size_t i = 0; i < SIZE; ++i) {
+            assert(v[i].id == static_cast<int>(i));
+        }
     }
-    try {
-        const size_t NUM = 10;
-        C c;
+    {
+        using Alloc = ExpandingAllocator<Obj>;
+        Alloc::Region region;
+        Obj::ResetCounters();
         {
-            cerr << "Vector:"sv << endl;
-            C::Reset();
-            Vector<C> v(NUM);
-            Dump();
-            v.PushBack(c);
+            Vector<Obj, Alloc> v{ Alloc(&region) };
+            v.Reserve(1);
+            const Obj* data = &*v.begin();
+            for (int i = 0; i < 100; ++i) {
+                v.EmplaceBack(i);
+            }
+            // Блок рос на месте: элементы не перемещались
+            assert(&*v.begin() == data);
+            assert(Obj::num_moved == 0);
+            assert(Obj::num_copied == 0);
+            assert(region.expansions > 0);
+            assert(v[99].id == 99);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+}
+
+void Test10() {
+    {
+        Vector<int, std::allocator<int>, OneAndHalfGrowth> v;
+        std::vector<size_t> capacities;
+        for (int i = 0; i < 10; ++i) {
+            v.PushBack(i);
+            if (capacities.empty() || capacities.back() != v.Capacity()) {
+                capacities.push_back(v.Capacity());
+            }
+        }
+        assert((capacities == std::vector<size_t>{ 1, 2, 3, 4, 6, 9, 13 }));
+    }
+    {
+        Vector<int, std::allocator<int>, MinimumFirstAllocation<DoublingGrowth, 4>> v;
+        v.PushBack(1);
+        assert(v.Capacity() == 4);
+        v.Emplace(v.cbegin(), 0);
+        assert(v.Capacity() == 4);
+    }
+    {
+        Vector<int, std::allocator<int>, CacheLineGrowth> v;
+        v.EmplaceBack(1);
+        assert(v.Capacity() == CACHE_LINE_BYTES / sizeof(int));
+    }
+    {
+        Vector<char, std::allocator<char>, PageGrowth> v;
+        for (size_t i = 0; i < PAGE_BYTES * 20; ++i) {
+            v.PushBack('a');
+            assert(v.Capacity() < PAGE_BYTES * 16 || v.Capacity() % PAGE_BYTES == 0);
+        }
+        assert(v.Capacity() % PAGE_BYTES == 0);
+    }
+}
+
+void Test11() {
+    using namespace std::literals;
+    const size_t SIZE = 4;
+    {
+        Obj::ResetCounters();
+        SmallVector<Obj, SIZE> v;
+        assert(v.Capacity() == SIZE);
+        assert(v.IsInline());
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(static_cast<int>(i), "Ivan"s);
+        }
+        assert(v.IsInline());
+        assert(Obj::num_moved == 0);
+        const Obj* inline_data = &*v.begin();
+        assert(static_cast<const void*>(inline_data) >= static_cast<const void*>(&v));
+        assert(static_cast<const void*>(inline_data) < static_cast<const void*>(&v + 1));
+
+        v.EmplaceBack(static_cast<int>(SIZE));
+        assert(!v.IsInline());
+        assert(v.Capacity() == SIZE * 2);
+        assert(Obj::num_moved == static_cast<int>(SIZE));
+        for (size_t i = 0; i <= SIZE; ++i) {
+            assert(v[i].id == static_cast<int>(i));
         }
-        Dump();
+        // Вектор в куче при перемещении отдаёт свой буфер
+        const Obj* heap_data = &*v.begin();
+        SmallVector<Obj, SIZE> moved(std::move(v));
+        assert(&*moved.begin() == heap_data);
+        assert(v.Size() == 0 && v.IsInline());
+        assert(Obj::num_moved == static_cast<int>(SIZE));
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Obj::ResetCounters();
+        SmallVector<Obj, SIZE> v(SIZE - 1);
+        SmallVector<Obj, SIZE> moved(std::move(v));
+        // Элементы встроенного буфера переносятся по одному
+        assert(moved.IsInline());
+        assert(moved.Size() == SIZE - 1);
+        assert(Obj::num_moved == static_cast<int>(SIZE) - 1);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE) - 1);
+
+        v = moved;
+        assert(v.Size() == SIZE - 1);
+        v.Insert(v.cbegin() + 1, Obj{ 42 });
+        assert(v.Size() == SIZE && v.IsInline());
+        assert(v[1].id == 42);
+        v.Erase(v.cbegin());
+        assert(v[0].id == 42);
+        v.Swap(moved);
+        assert(v.Size() == SIZE - 1);
+        assert(moved[0].id == 42);
     }
-    catch (...) {
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Obj::ResetCounters();
+        Obj::default_construction_throw_countdown = 3;
+        try {
+            SmallVector<Obj, SIZE> v(SIZE * 2);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
     }
+    {
+        Obj::ResetCounters();
+        SmallVector<Obj, SIZE> v(SIZE * 2);
+        v[SIZE].throw_on_copy = true;
+        try {
+            SmallVector<Obj, SIZE> v_copy(v);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+            assert(Obj::num_copied == static_cast<int>(SIZE));
+        }
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE) * 2);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        SmallVector<TestObj, 1> v(1);
+        v.PushBack(v[0]);
+        v.Emplace(v.cbegin(), std::move(v[1]));
+        v.Insert(v.cbegin() + 1, v[0]);
+        assert(v.Size() == 4);
+        assert(std::all_of(v.begin(), v.end(), [](const TestObj& obj) {
+            return obj.IsAlive();
+            }));
+        v.Resize(1);
+        assert(v.Size() == 1 && v[0].IsAlive());
+    }
+    {
+        SmallVector<std::unique_ptr<int>, 2> v;
+        for (int i = 0; i < 10; ++i) {
+            v.PushBack(std::make_unique<int>(i));
+        }
+        v.Erase(v.cbegin() + 3);
+        v.Emplace(v.cbegin(), std::make_unique<int>(-1));
+        assert(*v[0] == -1 && *v[4] == 4);
+    }
+}
+
+void Test12() {
+    const size_t SIZE = 10;
+    {
+        using Alloc = TaggedAllocator<Obj, false>;
+        AllocStats stats;
+        Obj::ResetCounters();
+        Vector<Obj, Alloc> v(SIZE, Alloc(1, &stats));
+        std::vector<Obj> src;
+        for (int i = 0; i < 5; ++i) {
+            src.emplace_back(100 + i);
+        }
+        const int old_copies = Obj::num_copied;
+        auto pos = v.Insert(v.cbegin() + 2, src.begin(), src.end());
+        assert(stats.allocations == 2);
+        assert(&*pos == &v[2]);
+        assert(v.Size() == SIZE + src.size());
+        assert(v[2].id == 100 && v[6].id == 104 && v[7].id == 0);
+        assert(Obj::num_copied == old_copies + static_cast<int>(src.size()));
+
+        v.Reserve(v.Size() + 20);
+        const int allocations = stats.allocations;
+        v.Insert(v.cbegin() + 1, src.begin(), src.begin() + 2);
+        v.Insert(v.cbegin() + 3, src.begin(), src.end());
+        v.Insert(v.cend() - 1, src.begin(), src.end());
+        assert(stats.allocations == allocations);
+        assert(v.Size() == SIZE + 17);
+        assert(v[1].id == 100 && v[2].id == 101 && v[3].id == 100 && v[7].id == 104);
+        assert(v[v.Size() - 6].id == 100 && v[v.Size() - 2].id == 104);
+        assert(std::all_of(v.begin(), v.end(), [](const Obj& obj) {
+            return obj.id == 0 || obj.id >= 100;
+            }));
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        std::vector<Obj> src(3);
+        src[1].throw_on_copy = true;
+        try {
+            v.Insert(v.cbegin() + 1, src.begin(), src.end());
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        // При реаллокации действует строгая гарантия
+        assert(v.Size() == SIZE);
+        assert(v.Capacity() == SIZE);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE) + 3);
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v;
+        v.Reserve(SIZE * 2);
+        for (int i = 0; i < static_cast<int>(SIZE); ++i) {
+            v.EmplaceBack(i + 1);
+        }
+        std::vector<Obj> src(5);
+        src[2].throw_on_copy = true;
+        // Вставка без реаллокации: хвост длиннее диапазона и короче его
+        for (const size_t index : { size_t{ 1 }, SIZE - 2 }) {
+            try {
+                v.Insert(v.cbegin() + index, src.begin(), src.end());
+                assert(false && "Exception is expected");
+            }
+            catch (const std::runtime_error&) {
+            }
+            assert(v.Size() == SIZE && v.Capacity() == SIZE * 2);
+            for (int i = 0; i < static_cast<int>(SIZE); ++i) {
+                assert(v[i].id == i + 1);
+            }
+        }
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE) + 5);
+    }
+    {
+        struct Checked {
+            explicit Checked(int value)
+                : value(value)  //
+            {
+                if (value < 0) {
+                    throw std::runtime_error("Negative");
+                }
+            }
+            int value;
+        };
+        Vector<Checked> v;
+        for (int i = 0; i < 3; ++i) {
+            v.EmplaceBack(i);
+        }
+        std::istringstream input("7 8 -1 9");
+        try {
+            v.Insert(v.cbegin() + 1, std::istream_iterator<int>(input), std::istream_iterator<int>());
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == 3 && v[0].value == 0 && v[1].value == 1 && v[2].value == 2);
+    }
+    {
+        Vector<int> v;
+        v.Insert(v.cbegin(), { 1, 2, 3 });
+        v.Insert(v.cbegin() + 1, 3, v[0]);
+        assert((std::vector<int>(v.begin(), v.end()) == std::vector<int>{ 1, 1, 1, 1, 2, 3 }));
+        v.Append(v.begin(), v.end());
+        assert(v.Size() == 12 && v[6] == 1 && v[11] == 3);
+
+        std::istringstream input("7 8 9");
+        v.Insert(v.cbegin() + 1, std::istream_iterator<int>(input), std::istream_iterator<int>());
+        assert(v.Size() == 15 && v[0] == 1 && v[1] == 7 && v[3] == 9 && v[4] == 1);
+
+        const int values[] = { 5, 6 };
+        v.Assign(std::begin(values), std::end(values));
+        assert(v.Size() == 2 && v[0] == 5 && v[1] == 6);
+    }
+    {
+        Vector<TestObj> v(SIZE);
+        v.Insert(v.cbegin() + 2, 4, v[3]);
+        v.Insert(v.cend() - 1, 20, v[0]);
+        assert(v.Size() == SIZE + 24);
+        assert(std::all_of(v.begin(), v.end(), [](const TestObj& obj) {
+            return obj.IsAlive();
+            }));
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        std::vector<Obj> src(SIZE / 2);
+        v.Assign(src.begin(), src.end());
+        assert(v.Size() == SIZE / 2 && v.Capacity() == SIZE);
+        src.resize(SIZE * 2);
+        v.Assign(src.begin(), src.end());
+        assert(v.Size() == SIZE * 2 && v.Capacity() == SIZE * 2);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE) * 4);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test13() {
+    const size_t SIZE = 10;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        for (size_t i = 0; i < SIZE; ++i) {
+            v[i].id = static_cast<int>(i);
+        }
+        auto pos = v.Erase(v.cbegin() + 2, v.cbegin() + 5);
+        assert(&*pos == &v[2]);
+        assert(v.Size() == SIZE - 3);
+        assert(v.Capacity() == SIZE);
+        assert(v[1].id == 1 && v[2].id == 5);
+        assert(Obj::num_move_assigned == static_cast<int>(SIZE) - 5);
+        assert(Obj::num_destroyed == 3);
+
+        const int old_move_assigned = Obj::num_move_assigned;
+        const int old_destroyed = Obj::num_destroyed;
+        const size_t erased = v.EraseIf([](const Obj& obj) {
+            return obj.id % 2 == 1;
+            });
+        assert(erased == 4);
+        assert(v.Size() == 3);
+        assert(v[0].id == 0 && v[1].id == 6 && v[2].id == 8);
+        // Перемещаются только элементы, стоящие после первого удалённого
+        assert(Obj::num_move_assigned == old_move_assigned + 2);
+        assert(Obj::num_destroyed == old_destroyed + 4);
+
+        v.Clear();
+        assert(v.Size() == 0);
+        assert(v.Capacity() == SIZE);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Handle::ResetCounters();
+        Vector<Handle> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(static_cast<int>(i));
+        }
+        v.Erase(v.cbegin(), v.cbegin() + 2);
+        const size_t erased = v.EraseIf([](const Handle& h) {
+            return h.id % 3 == 0;
+            });
+        assert(erased == 3);
+        assert(v.Size() == SIZE - 5);
+        assert(v[0].id == 2 && v[1].id == 4 && v[4].id == 8);
+        assert(Handle::num_moved == 0);
+        assert(Handle::num_destroyed == 5);
+    }
+    {
+        Vector<std::unique_ptr<int>> v;
+        for (int i = 0; i < static_cast<int>(SIZE); ++i) {
+            v.PushBack(std::make_unique<int>(i));
+        }
+        try {
+            v.EraseIf([](const std::unique_ptr<int>& p) {
+                if (*p == 6) {
+                    throw std::runtime_error("Oops");
+                }
+                return *p % 2 == 0;
+                });
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == SIZE - 3);
+        assert(*v[0] == 1 && *v[2] == 5 && *v[3] == 6 && *v[6] == 9);
+    }
+}
+
+void Test14() {
+    const size_t SIZE = 10;
+    {
+        Vector<int> v(SIZE, DEFAULT_INIT);
+        assert(v.Size() == SIZE);
+        assert(v.Capacity() == SIZE);
+        v.ResizeDefaultInit(SIZE * 2);
+        assert(v.Size() == SIZE * 2);
+        v.ResizeForOverwrite(SIZE * 3, [](int* data, size_t count) {
+            for (size_t i = 0; i < count / 2; ++i) {
+                data[i] = static_cast<int>(i);
+            }
+            return count / 2;
+            });
+        assert(v.Size() == SIZE * 3 / 2);
+        assert(v.Capacity() == SIZE * 3);
+        assert(v[SIZE] == static_cast<int>(SIZE));
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE, DEFAULT_INIT);
+        // Нетривиальные типы по-прежнему конструируются
+        assert(Obj::num_default_constructed == static_cast<int>(SIZE));
+        v[0].id = 42;
+        v.Resize(SIZE * 4, v[0]);
+        assert(v.Size() == SIZE * 4);
+        assert(v[SIZE * 4 - 1].id == 42);
+        assert(Obj::num_copied == static_cast<int>(SIZE) * 3 + 1);
+        v.Resize(1, Obj{ 7 });
+        assert(v.Size() == 1 && v[0].id == 42);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test15() {
+    const size_t SIZE = 100'500;
+    const size_t NEW_SIZE = 10'000;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        v.Resize(NEW_SIZE);
+        assert(v.MemoryUsage() == SIZE * sizeof(Obj));
+        assert(v.SlackBytes() == (SIZE - NEW_SIZE) * sizeof(Obj));
+        const int old_num_moved = Obj::num_moved;
+        v.ShrinkToFit();
+        assert(v.Size() == NEW_SIZE);
+        assert(v.Capacity() == NEW_SIZE);
+        assert(v.SlackBytes() == 0);
+        assert(Obj::num_moved == old_num_moved + static_cast<int>(NEW_SIZE));
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(NEW_SIZE));
+
+        v.Clear();
+        v.ShrinkToFit();
+        assert(v.Capacity() == 0);
+        assert(v.MemoryUsage() == 0);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Vector<int, MallocAllocator<int>> v(SIZE);
+        v[NEW_SIZE - 1] = 42;
+        v.Resize(NEW_SIZE);
+        v.ShrinkToFit();
+        assert(v.Capacity() == NEW_SIZE);
+        assert(v[NEW_SIZE - 1] == 42);
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        v.Reserve(SIZE * 2);
+        v[0].throw_on_copy = true;
+        v.ShrinkToFit();
+        // Move-конструктор Obj не выбрасывает исключений, поэтому копирования нет
+        assert(Obj::num_copied == 0);
+        assert(v.Capacity() == SIZE);
+    }
+}
+
+void Test16() {
+    const size_t SIZE = 100;
+    {
+        Vector<Obj, std::allocator<Obj>, DoublingGrowth, VectorStats> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(static_cast<int>(i));
+        }
+        const VectorStatsCounters& stats = v.GetStats().Get();
+        assert(stats.allocations == 8);
+        assert(stats.reallocations == 7);
+        assert(stats.allocated_bytes == (1 + 2 + 4 + 8 + 16 + 32 + 64 + 128) * sizeof(Obj));
+        assert(stats.relocated_by_move == 127);
+        assert(stats.relocated_by_copy == 0);
+        assert(stats.peak_capacity == 128);
+
+        v.Clear();
+        v.ShrinkToFit();
+        assert(v.GetStats().Get().peak_capacity == 128);
+    }
+    {
+        Vector<MaybeThrowingMove, std::allocator<MaybeThrowingMove>, DoublingGrowth, VectorStats> v(SIZE);
+        v.Reserve(SIZE * 2);
+        const VectorStatsCounters& stats = v.GetStats().Get();
+        assert(stats.allocations == 2);
+        assert(stats.relocated_by_copy == SIZE);
+        assert(stats.relocated_by_move == 0);
+    }
+    {
+        using IngestVector = Vector<int, MallocAllocator<int>, DoublingGrowth, GlobalVectorStats<IngestTag>>;
+        IngestVector v1;
+        IngestVector v2;
+        v1.Reserve(SIZE);
+        v2.Reserve(SIZE * 2);
+        for (size_t i = 0; i < SIZE; ++i) {
+            v1.PushBack(static_cast<int>(i));
+        }
+        v1.PushBack(0);
+        assert(v1.GetStats().Get().relocated_bitwise == SIZE);
+
+        const VectorStatsCounters total = GlobalVectorStats<IngestTag>::Total();
+        assert(total.allocations == 3);
+        assert(total.reallocations == 1);
+        assert(total.relocated_bitwise == SIZE);
+        assert(total.peak_capacity == SIZE * 2);
+
+        bool found = false;
+        VectorStatsRegistry::Instance().ForEach([&found](const char* name, const VectorStatsCounters& counters) {
+            if (std::string(name) == "ingest") {
+                found = counters.allocations == 3;
+            }
+            });
+        assert(found);
+    }
+}
+
+void Test17() {
+    const int THREADS = 4;
+    const int PER_THREAD = 5000;
+    {
+        ConcurrentVector<std::string> v;
+        const std::string* first = &v.EmplaceBack("first");
+
+        std::vector<std::thread> writers;
+        for (int t = 0; t < THREADS; ++t) {
+            writers.emplace_back([&v, t] {
+                for (int i = 0; i < PER_THREAD; ++i) {
+                    v.PushBack(std::to_string(t * PER_THREAD + i));
+                }
+            });
+        }
+        // Читатель видит только полностью сконструированные элементы
+        std::thread reader([&v] {
+            size_t seen = 0;
+            while (seen < THREADS * PER_THREAD + 1) {
+                const size_t size = v.Size();
+                assert(size >= seen);
+                for (size_t i = seen; i < size; ++i) {
+                    assert(!v[i].empty());
+                }
+                seen = size;
+                std::this_thread::yield();
+            }
+        });
+        for (auto& writer : writers) {
+            writer.join();
+        }
+        reader.join();
+
+        assert(v.Size() == THREADS * PER_THREAD + 1);
+        assert(v.ReservedSize() == v.Size());
+        assert(&v[0] == first && *first == "first");
+
+        std::vector<bool> present(THREADS * PER_THREAD);
+        size_t count = 0;
+        for (auto it = ++v.begin(); it != v.end(); ++it) {
+            present[std::stoi(*it)] = true;
+            ++count;
+        }
+        assert(count == present.size());
+        for (bool p : present) {
+            assert(p);
+        }
+    }
+    {
+        ConcurrentVector<int> v;
+        std::vector<std::thread> writers;
+        for (int t = 0; t < THREADS; ++t) {
+            writers.emplace_back([&v] {
+                for (int i = 0; i < 10; ++i) {
+                    const size_t first = v.GrowBy(100);
+                    for (size_t j = first; j < first + 100; ++j) {
+                        assert(v[j] == 0);
+                    }
+                }
+            });
+        }
+        for (auto& writer : writers) {
+            writer.join();
+        }
+        assert(v.Size() == THREADS * 10 * 100);
+    }
+    {
+        Obj::ResetCounters();
+        {
+            ConcurrentVector<Obj> v;
+            for (int i = 0; i < 1000; ++i) {
+                v.EmplaceBack(i);
+            }
+            assert(Obj::GetAliveObjectCount() == 1000);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+}
+
+void Test18() {
+    const size_t SIZE = 10000;
+    const ParallelTag POLICY{ 4, 100 };
+    SharedObj::ResetCounters();
+    {
+        Vector<SharedObj> v(POLICY, SIZE);
+        assert(v.Size() == SIZE && SharedObj::num_alive == static_cast<int>(SIZE));
+        for (size_t i = 0; i < SIZE; ++i) {
+            v[i].id = static_cast<int>(i);
+        }
+
+        Vector<SharedObj> v_copy(POLICY, v);
+        assert(v_copy.Size() == SIZE && v_copy[SIZE - 1].id == static_cast<int>(SIZE - 1));
+
+        Vector<SharedObj> small(3);
+        small.CopyFrom(POLICY, v);
+        assert(small.Size() == SIZE && small[SIZE / 2].id == static_cast<int>(SIZE / 2));
+        v_copy.Resize(POLICY, SIZE / 2);
+        v_copy.CopyFrom(POLICY, v);
+        assert(v_copy.Size() == SIZE && v_copy[SIZE - 1].id == static_cast<int>(SIZE - 1));
+        v_copy.Resize(POLICY, 10);
+        v_copy.CopyFrom(PARALLEL, v);
+        assert(v_copy.Size() == SIZE);
+
+        small.Clear(POLICY);
+        assert(small.Size() == 0 && small.Capacity() >= SIZE);
+        assert(SharedObj::num_alive == static_cast<int>(SIZE * 2));
+    }
+    assert(SharedObj::num_alive == 0);
+    {
+        // Исключение в одной из частей: созданные в других потоках объекты разрушаются
+        SharedObj::default_construction_throw_countdown = SIZE / 2;
+        try {
+            Vector<SharedObj> v(POLICY, SIZE);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(SharedObj::num_alive == 0);
+    }
+    SharedObj::ResetCounters();
+    {
+        Vector<SharedObj> v(SIZE);
+        v[SIZE - 1].throw_on_copy = true;
+        try {
+            Vector<SharedObj> v_copy(POLICY, v);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(SharedObj::num_alive == static_cast<int>(SIZE));
+
+        Vector<SharedObj> dst(1);
+        try {
+            dst.CopyFrom(POLICY, v);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(dst.Size() == 1 && dst.Capacity() == 1);
+        assert(SharedObj::num_alive == static_cast<int>(SIZE + 1));
+
+        v[SIZE - 1].throw_on_copy = false;
+        v.Reserve(SIZE * 2);
+        SharedObj::default_construction_throw_countdown = SIZE / 3;
+        try {
+            v.Resize(POLICY, SIZE * 2);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == SIZE);
+        assert(SharedObj::num_alive == static_cast<int>(SIZE + 1));
+    }
+    assert(SharedObj::num_alive == 0);
+}
+
+void Test19() {
+    const size_t SIZE = 100;
+    {
+        using AlignedVector = Vector<float, AlignedAllocator<float, 64>>;
+        AlignedVector v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack(static_cast<float>(i));
+            assert(reinterpret_cast<std::uintptr_t>(v.begin()) % 64 == 0);
+            // Вместимость кратна ширине 512-битного регистра
+            assert(v.Capacity() % 16 == 0);
+        }
+        assert(v.AssumeAligned() == v.begin());
+
+        const AlignedVector copy(v);
+        assert(reinterpret_cast<std::uintptr_t>(copy.AssumeAligned()) % 64 == 0);
+        assert(copy.Capacity() == 112 && copy[SIZE - 1] == static_cast<float>(SIZE - 1));
+
+        v.ShrinkToFit();
+        assert(v.Capacity() == 112);
+        // Блок под Size() элементов снова получил бы вместимость 112: буфер остаётся прежним
+        const float* data = v.begin();
+        v.ShrinkToFit();
+        assert(v.begin() == data && v.Capacity() == 112);
+        AlignedVector empty;
+        assert(empty.AssumeAligned() == nullptr);
+    }
+    {
+        Obj::ResetCounters();
+        {
+            Vector<Obj, AlignedAllocator<Obj, 256>> v(SIZE);
+            v.Reserve(SIZE * 3);
+            assert(reinterpret_cast<std::uintptr_t>(v.AssumeAligned<256>()) % 256 == 0);
+            assert(v.Capacity() >= SIZE * 3);
+            assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE));
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+}
+
+void Test20() {
+    struct Record {
+        int id;
+        double value;
+    };
+    const size_t SIZE = 10000;
+    const std::string path = "/tmp/mapped_vector_test_" + std::to_string(::getpid()) + ".bin";
+    {
+        auto v = MappedVector<Record>::Create(path);
+        assert(v.Size() == 0 && v.Capacity() > 0);
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack({ static_cast<int>(i), i * 0.5 });
+        }
+        // Аргумент ссылается на элемент вектора, который переедет при росте
+        while (v.Size() != v.Capacity()) {
+            v.PushBack(v[0]);
+        }
+        v.EmplaceBack(v[1]);
+        assert(v[v.Size() - 1].id == 1);
+        v.Resize(SIZE);
+        v.Sync();
+    }
+    {
+        auto v = MappedVector<Record>::Open(path);
+        assert(v.Size() == SIZE);
+        for (size_t i = 0; i < SIZE; ++i) {
+            assert(v[i].id == static_cast<int>(i) && v[i].value == i * 0.5);
+        }
+        v.PopBack();
+        auto moved = std::move(v);
+        moved.Resize(SIZE + 10, Record{ -1, 0.0 });
+        assert(moved[SIZE - 1].id == -1 && moved[SIZE + 9].id == -1);
+        // Перемещённый вектор пуст
+        assert(v.Size() == 0 && v.Capacity() == 0 && v.begin() == v.end());
+        v.Clear();
+        v.Resize(0);
+        v.Sync();
+        assert(v.Size() == 0);
+        MappedVector<Record> other = std::move(moved);
+        moved = std::move(v);
+        assert(moved.Size() == 0 && other.Size() == SIZE + 10);
+        v = std::move(other);
+        assert(v.Size() == SIZE + 10 && other.begin() == other.end());
+    }
+    {
+        assert(MappedVector<Record>::Open(path).Size() == SIZE + 10);
+        try {
+            MappedVector<int>::Open(path);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(MappedVector<Record>::Create(path).Size() == 0);
+    }
+    ::unlink(path.c_str());
+}
+
+void Test21() {
+    struct Sample {
+        int id;
+        double value;
+    };
+    const size_t SIZE = 100000;
+    {
+        Vector<int> v;
+        for (size_t i = 0; i < 10; ++i) {
+            v.PushBack(static_cast<int>(i));
+        }
+        const VectorView<int> view(v);
+        assert(view.Size() == 10 && view.Data() == v.begin());
+        view[0] = -1;
+        assert(v[0] == -1);
+
+        const VectorView<const int> tail = view.Subview(7);
+        assert(tail.Size() == 3 && tail[0] == 7);
+        assert(view.Subview(2, 3).Size() == 3 && *view.Subview(2, 3).begin() == 2);
+
+        const Vector<int>& cv = v;
+        VectorView<const int> const_view(cv);
+        SmallVector<int, 4> sv(3);
+        const_view = VectorView<int>(sv);
+        assert(const_view.Size() == 3 && VectorView<int>().Empty());
+    }
+    {
+        const std::string path = "/tmp/serialized_vector_test_" + std::to_string(::getpid()) + ".bin";
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        assert(fd >= 0);
+        Vector<Sample> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack({ static_cast<int>(i), i * 0.25 });
+        }
+        Serialize(fd, v);
+        Serialize(fd, VectorView<const Sample>(v).Subview(SIZE - 5));
+        Serialize(fd, Vector<int>());
+
+        ::lseek(fd, 0, SEEK_SET);
+        const auto restored = Deserialize<Sample>(fd);
+        assert(restored.Size() == SIZE && restored.Capacity() == SIZE);
+        for (size_t i = 0; i < SIZE; ++i) {
+            assert(restored[i].id == v[i].id && restored[i].value == v[i].value);
+        }
+        const auto tail = Deserialize<Sample>(fd);
+        assert(tail.Size() == 5 && tail[0].id == static_cast<int>(SIZE - 5));
+        assert(Deserialize<int>(fd).Size() == 0);
+        try {
+            Deserialize<int>(fd);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+
+        ::lseek(fd, 0, SEEK_SET);
+        try {
+            Deserialize<char>(fd);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        ::close(fd);
+        ::unlink(path.c_str());
+    }
+    {
+        Obj::ResetCounters();
+        {
+            Vector<Obj> v;
+            v.Reserve(10);
+            v.EmplaceBack(1);
+            v.EmplaceBack(2);
+            Vector<Obj>::RawBuffer buffer = v.Release();
+            assert(v.Size() == 0 && v.Capacity() == 0);
+            assert(buffer.size == 2 && buffer.capacity == 10);
+
+            const Vector<Obj> adopted = Vector<Obj>::FromRawBuffer(buffer);
+            assert(adopted.Size() == 2 && adopted.Capacity() == 10 && adopted[1].id == 2);
+            assert(Obj::num_copied == 0 && Obj::num_moved == 0);
+            assert(Obj::GetAliveObjectCount() == 2);
+
+            std::allocator<int> alloc;
+            int* raw = alloc.allocate(4);
+            raw[0] = 42;
+            Vector<int> wrapped = Vector<int>::FromRawBuffer({ raw, 1, 4 });
+            wrapped.PushBack(43);
+            assert(wrapped.begin() == raw && wrapped[1] == 43);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+}
+
+void Test22() {
+    const size_t SIZE = 10;
+    SharedObj::ResetCounters();
+    // Копирование помеченного элемента выбрасывает исключение, а перемещения нет,
+    // поэтому при реаллокации элементы копируются
+    auto make_full = [SIZE](size_t throwing_index) {
+        Vector<SharedObj> v(SIZE);
+        for (size_t i = 0; i < SIZE; ++i) {
+            v[i].id = static_cast<int>(i);
+        }
+        v[throwing_index].throw_on_copy = true;
+        return v;
+    };
+    auto expect_unchanged = [SIZE](const Vector<SharedObj>& v, size_t capacity) {
+        assert(v.Size() == SIZE && v.Capacity() == capacity);
+        for (size_t i = 0; i < SIZE; ++i) {
+            assert(v[i].id == static_cast<int>(i));
+        }
+        assert(SharedObj::num_alive == static_cast<int>(SIZE));
+    };
+    auto expect_throw = [](auto operation) {
+        try {
+            operation();
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+    };
+
+    for (size_t throwing_index : { size_t{ 0 }, SIZE / 2, SIZE - 1 }) {
+        Vector<SharedObj> v = make_full(throwing_index);
+        expect_throw([&v] { v.EmplaceBack(); });
+        expect_unchanged(v, SIZE);
+        expect_throw([&v] { v.Emplace(v.begin() + 1); });
+        expect_unchanged(v, SIZE);
+        expect_throw([&v, SIZE] { v.Emplace(v.begin() + SIZE - 1); });
+        expect_unchanged(v, SIZE);
+        expect_throw([&v] { v.Insert(v.cbegin() + 2, 3, SharedObj()); });
+        expect_unchanged(v, SIZE);
+        expect_throw([&v] { v.Reserve(SIZE * 2); });
+        expect_unchanged(v, SIZE);
+    }
+    assert(SharedObj::num_alive == 0);
+    {
+        // Исключение при создании нового элемента до переноса старых
+        Vector<SharedObj> v = make_full(0);
+        v[0].throw_on_copy = false;
+        SharedObj bad;
+        bad.throw_on_copy = true;
+        expect_throw([&v, &bad] { v.PushBack(bad); });
+        expect_throw([&v, &bad] { v.Insert(v.cbegin() + 1, bad); });
+        expect_throw([&v, &bad] { v.Insert(v.cbegin() + 1, 2, bad); });
+        assert(SharedObj::num_alive == static_cast<int>(SIZE + 1));
+
+        v.Reserve(SIZE + 1);
+        expect_throw([&v, &bad] { v.PushBack(bad); });
+        // Аргумент ссылается на элемент вектора: копия создаётся до сдвига
+        v[0].throw_on_copy = true;
+        expect_throw([&v] { v.Insert(v.cbegin() + 1, v[0]); });
+        v[0].throw_on_copy = false;
+        assert(v.Size() == SIZE && v.Capacity() == SIZE + 1);
+        assert(SharedObj::num_alive == static_cast<int>(SIZE + 1));
+    }
+    {
+        // Вставка без реаллокации: исключение при сдвиге последнего элемента
+        Vector<SharedObj> v = make_full(SIZE - 1);
+        v[SIZE - 1].throw_on_copy = false;
+        v.Reserve(SIZE * 2);
+        v[SIZE - 1].throw_on_copy = true;
+        expect_throw([&v] { v.Emplace(v.begin()); });
+        expect_unchanged(v, SIZE * 2);
+        expect_throw([&v] { v.ShrinkToFit(); });
+        expect_unchanged(v, SIZE * 2);
+    }
+    assert(SharedObj::num_alive == 0);
+    {
+        SmallVector<SharedObj, 4> v(4);
+        v[2].throw_on_copy = true;
+        expect_throw([&v] { v.EmplaceBack(); });
+        expect_throw([&v] { v.Emplace(v.begin() + 1); });
+        expect_throw([&v] { v.Reserve(8); });
+        assert(v.Size() == 4 && v.IsInline() && v[2].throw_on_copy);
+        assert(SharedObj::num_alive == 4);
+
+        v[2].throw_on_copy = false;
+        v.EmplaceBack();
+        assert(v.Size() == 5 && !v.IsInline());
+        assert(SharedObj::num_alive == 5);
+    }
+    assert(SharedObj::num_alive == 0);
+}
+
+void Test23() {
+    BufferCache& cache = BufferCache::Local();
+    cache.Trim();
+    {
+        auto handle_request = [] {
+            RecyclingVector<std::string> v;
+            for (int i = 0; i < 100; ++i) {
+                v.PushBack("id");
+            }
+            RecyclingVector<std::string> copy(v);
+            assert(copy.Size() == 100);
+        };
+        // Первый запрос наполняет кэш, дальше память берётся только из него
+        handle_request();
+        const size_t misses = cache.Misses();
+        const size_t hits = cache.Hits();
+        for (int request = 0; request < 100; ++request) {
+            handle_request();
+        }
+        assert(cache.Misses() == misses);
+        assert(cache.Hits() > hits);
+        assert(cache.CachedBytes() > 0);
+
+        cache.Trim();
+        assert(cache.CachedBytes() == 0);
+    }
+    {
+        RecyclingVector<int> v;
+        v.Reserve(100);
+        // Вместимость округлена до класса размера
+        assert(v.Capacity() == 128);
+        RecyclingVector<char> one;
+        one.PushBack('a');
+        assert(one.Capacity() == 16);
+    }
+    {
+        cache.SetCapacityBytes(1024);
+        cache.Trim();
+        {
+            RecyclingVector<int> small(100);
+            RecyclingVector<int> large(1000);
+        }
+        // Блок на 4 КиБ не помещается в кэш
+        assert(cache.CachedBytes() == 512);
+        cache.SetCapacityBytes(256);
+        assert(cache.CachedBytes() == 0);
+        cache.SetCapacityBytes(BufferCache::DEFAULT_CAPACITY_BYTES);
+    }
+    {
+        // У каждого потока свой кэш
+        RecyclingVector<int> v(100);
+        const size_t misses = cache.Misses();
+        std::thread([] {
+            BufferCache& thread_cache = BufferCache::Local();
+            RecyclingVector<int> w(100);
+            assert(thread_cache.Misses() == 1);
+        }).join();
+        assert(cache.Misses() == misses);
+    }
+}
+
+void Test24() {
+    const size_t SIZE = 1000;
+    {
+        Arena arena(1 << 12);
+        ArenaVector<int> v(arena);
+        v.Reserve(1);
+        const int* first = v.begin();
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack(static_cast<int>(i));
+            if (v.Capacity() * sizeof(int) < (1 << 12) - 64) {
+                // Последний буфер арены растёт на месте
+                assert(v.begin() == first);
+            }
+        }
+        assert(v[SIZE - 1] == static_cast<int>(SIZE - 1));
+        assert(arena.AllocatedBytes() >= SIZE * sizeof(int));
+
+        // Перемещение и Swap внутри арены передают буфер без копирования
+        ArenaVector<int> other(arena);
+        other.PushBack(-1);
+        const int* data = v.begin();
+        other = std::move(v);
+        assert(other.begin() == data && other.Size() == SIZE);
+        ArenaVector<int> third(std::move(other));
+        assert(third.begin() == data);
+        ArenaVector<int> small(arena);
+        small.PushBack(7);
+        third.Swap(small);
+        assert(small.begin() == data && third[0] == 7);
+    }
+    {
+        Arena arena;
+        Obj::ResetCounters();
+        {
+            ArenaVector<Obj> v(arena);
+            for (size_t i = 0; i < 100; ++i) {
+                v.EmplaceBack(static_cast<int>(i));
+            }
+            const ArenaVector<Obj> copy(v);
+            assert(copy.GetAllocator() == v.GetAllocator());
+            assert(Obj::GetAliveObjectCount() == 200);
+
+            // Буферы разных арен не передаются: элементы перемещаются по одному
+            Arena other_arena;
+            ArenaVector<Obj> foreign(other_arena);
+            foreign = std::move(v);
+            assert(foreign.Size() == 100 && foreign[99].id == 99);
+            assert(&foreign.GetAllocator().GetArena() == &other_arena);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+        assert(arena.ReservedBytes() > 0);
+        arena.Release();
+        assert(arena.ReservedBytes() == 0 && arena.AllocatedBytes() == 0);
+    }
+    {
+        Arena arena(256);
+        void* a = arena.Allocate(100, 8);
+        void* b = arena.Allocate(1000, 64);
+        assert(reinterpret_cast<std::uintptr_t>(b) % 64 == 0);
+        assert(!arena.TryExtend(a, 100, 120));
+        arena.Deallocate(b, 1000);
+        assert(arena.AllocatedBytes() == 100);
+    }
+    {
+        // Кусок под крупный запрос заполнен почти целиком: выровненный адрес не помещается в остаток
+        Arena arena(100000);
+        arena.Allocate(100001, 1);
+        const size_t reserved = arena.ReservedBytes();
+        auto* p = static_cast<unsigned char*>(arena.Allocate(8, 8));
+        assert(reinterpret_cast<std::uintptr_t>(p) % 8 == 0);
+        assert(arena.ReservedBytes() > reserved);
+        std::fill(p, p + 8, 0xff);
+    }
+}
+
+void Test25() {
+    using namespace std::literals;
+    {
+        SoAVector<int, double, std::string> v;
+        for (int i = 0; i < 100; ++i) {
+            v.EmplaceBack(i, i * 0.5, std::to_string(i));
+        }
+        assert(v.Size() == 100 && v.Capacity() >= 100);
+
+        // Столбцы непрерывны и обходятся без остальных полей
+        const VectorView<int> ids = v.Column<0>();
+        assert(ids.Size() == 100 && ids[99] == 99);
+        assert(v.Column<1>().Data() + 1 == &v[1].Get<1>());
+        double sum = 0;
+        for (double price : v.Column<1>()) {
+            sum += price;
+        }
+        assert(sum == 4950 * 0.5);
+
+        // Прокси-ссылки изменяют поля строки во всех столбцах
+        v[3].Get<2>() = "three"s;
+        v[4] = std::make_tuple(-4, -2.0, "minus four"s);
+        assert(v.Column<2>()[3] == "three"s);
+        assert(v[4].Get<0>() == -4 && v.Column<1>()[4] == -2.0);
+        const std::tuple<int, double, std::string> row = v[4];
+        assert(std::get<2>(row) == "minus four"s);
+
+        // Присваивание строки строке копирует поля
+        v[5] = v[4];
+        assert(v[5].Get<0>() == -4 && v[5].Get<1>() == -2.0 && v[5].Get<2>() == "minus four"s);
+        assert(v[4].Get<2>() == "minus four"s);
+        const auto& const_rows = v;
+        v[6] = const_rows[3];
+        assert(v[6].Get<0>() == 3 && v[6].Get<2>() == "three"s);
+        v[5] = std::make_tuple(5, 2.5, "5"s);
+        v[6] = std::make_tuple(6, 3.0, "6"s);
+
+        int count = 0;
+        for (auto r : v) {
+            if (r.Get<0>() >= 0) {
+                ++count;
+            }
+        }
+        assert(count == 99);
+        assert(v.end() - v.begin() == 100);
+        assert((*(v.begin() + 5)).Get<2>() == "5"s);
+        // Итератор строк поддерживает все операции произвольного доступа, в том числе с const_iterator
+        assert(5 + v.begin() == v.begin() + 5 && v.cend() > v.begin() && v.begin() <= v.cbegin());
+        assert(v.end() >= v.cend() && v.cend() - v.begin() == 100);
+
+        const auto& cv = v;
+        assert(cv.begin()[10].Get<0>() == 10);
+        const SoAVector<int, double, std::string> copy(v);
+        assert(copy.Size() == 100 && copy[99].Get<2>() == "99"s);
+
+        // Аргументы могут ссылаться на строку этого же вектора
+        SoAVector<int, double, std::string> full;
+        full.Reserve(2);
+        full.EmplaceBack(1, 1.0, "a long string that does not fit into SSO"s);
+        full.EmplaceBack(2, 2.0, "b"s);
+        full.EmplaceBack(full[0].Get<0>(), full[0].Get<1>(), full[0].Get<2>());
+        assert(full.Size() == 3 && full[2].Get<2>() == full[0].Get<2>());
+        full.PopBack();
+        assert(full.Size() == 2 && full.Capacity() == 4);
+    }
+    {
+        SharedObj::ResetCounters();
+        {
+            SoAVector<std::string, SharedObj, int> v;
+            v.Reserve(4);
+            for (int i = 0; i < 4; ++i) {
+                v.EmplaceBack(std::to_string(i), SharedObj(), i);
+            }
+            assert(SharedObj::num_alive == 4);
+
+            // Исключение при переносе столбца оставляет вектор нетронутым
+            v[2].Get<1>().throw_on_copy = true;
+            const std::string* names = v.Column<0>().Data();
+            try {
+                v.EmplaceBack("4"s, SharedObj(), 4);
+                assert(false);
+            }
+            catch (const std::runtime_error&) {
+            }
+            assert(v.Size() == 4 && v.Capacity() == 4);
+            assert(v.Column<0>().Data() == names && v[3].Get<0>() == "3"s);
+            assert(SharedObj::num_alive == 4);
+
+            // Исключение при создании поля разрушает уже созданные поля строки
+            v[2].Get<1>().throw_on_copy = false;
+            v.Reserve(8);
+            SharedObj bad;
+            bad.throw_on_copy = true;
+            try {
+                v.EmplaceBack("4"s, bad, 4);
+                assert(false);
+            }
+            catch (const std::runtime_error&) {
+            }
+            assert(v.Size() == 4 && SharedObj::num_alive == 5);
+
+            SharedObj::default_construction_throw_countdown = 3;
+            try {
+                v.Resize(8);
+                assert(false);
+            }
+            catch (const std::runtime_error&) {
+            }
+            assert(v.Size() == 4 && SharedObj::num_alive == 5);
+            SharedObj::default_construction_throw_countdown = 0;
+        }
+        assert(SharedObj::num_alive == 0);
+    }
+}
+
+void Test26() {
+    {
+        using Chunked = ChunkedVector<int, 64>;
+        static_assert(Chunked::CHUNK_SIZE == 16);
+        const size_t SIZE = 1000;
+        Chunked v;
+        v.PushBack(0);
+        const int* first = &v[0];
+        for (size_t i = 1; i < SIZE; ++i) {
+            v.PushBack(static_cast<int>(i));
+        }
+        // Элементы не перемещаются при росте
+        assert(&v[0] == first);
+        assert(v.Size() == SIZE && v.ChunkCount() == (SIZE + 15) / 16);
+        assert(v.end() - v.begin() == static_cast<std::ptrdiff_t>(SIZE));
+
+        long sum = 0;
+        size_t chunks = 0;
+        v.ForEachChunk([&](const int* data, size_t count) {
+            assert(count == 16 || chunks + 1 == v.ChunkCount());
+            for (size_t i = 0; i < count; ++i) {
+                sum += data[i];
+            }
+            ++chunks;
+        });
+        assert(chunks == v.ChunkCount() && sum == static_cast<long>(SIZE * (SIZE - 1) / 2));
+
+        std::sort(v.begin(), v.end(), std::greater<>());
+        assert(v[0] == static_cast<int>(SIZE - 1) && *(v.end() - 1) == 0);
+        assert(std::is_sorted(v.cbegin(), v.cend(), std::greater<>()));
+        assert(2 + v.begin() == v.begin() + 2 && v.cend() > v.begin() && v.cbegin() <= v.begin());
+        assert(v.end() >= v.cend() && v.cend() - v.begin() == static_cast<std::ptrdiff_t>(SIZE));
+
+        const Vector<int> flat = v.Flatten();
+        assert(flat.Size() == SIZE && flat[0] == static_cast<int>(SIZE - 1) && flat[SIZE - 1] == 0);
+
+        v.Resize(10);
+        assert(v.Size() == 10 && v.Capacity() >= SIZE);
+        v.ShrinkToFit();
+        assert(v.ChunkCount() == 1 && v.Capacity() == 16);
+        v.Clear();
+        assert(v.Size() == 0 && v.Capacity() == 16);
+    }
+    {
+        Obj::ResetCounters();
+        {
+            ChunkedVector<Obj, 256> v;
+            for (int i = 0; i < 50; ++i) {
+                v.EmplaceBack(i);
+            }
+            // Аргумент может ссылаться на элемент вектора
+            v.PushBack(v[0]);
+            assert(v[50].id == 0);
+            assert(Obj::num_moved == 0 && Obj::num_copied == 1);
+
+            v[10].throw_on_copy = true;
+            const size_t size = v.Size();
+            try {
+                v.PushBack(v[10]);
+                assert(false);
+            }
+            catch (const std::runtime_error&) {
+            }
+            assert(v.Size() == size);
+            try {
+                const ChunkedVector<Obj, 256> copy(v);
+                assert(false);
+            }
+            catch (const std::runtime_error&) {
+            }
+            assert(Obj::GetAliveObjectCount() == 51);
+            v[10].throw_on_copy = false;
+
+            const ChunkedVector<Obj, 256> copy(v);
+            assert(copy.Size() == size && copy[50].id == 0);
+            const Vector<Obj> flat = std::move(v).Flatten();
+            assert(v.Size() == 0 && flat.Size() == size && flat[49].id == 49);
+            assert(Obj::GetAliveObjectCount() == 102);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+
+        // Исключение в конструкторе с размером разрушает элементы, созданные в нескольких блоках
+        Obj::default_construction_throw_countdown = 10;
+        try {
+            const ChunkedVector<Obj, 256> v(16);
+            assert(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+        Obj::ResetCounters();
+    }
+}
+
+void Test27() {
+    {
+        Obj::ResetCounters();
+        {
+            IncrementalVector<Obj> v;
+            bool migrated = false;
+            for (int i = 0; i < 1000; ++i) {
+                const int moved = Obj::num_moved;
+                v.EmplaceBack(i);
+                // Одно добавление переносит не больше двух элементов
+                assert(Obj::num_moved - moved <= 2);
+                migrated = migrated || v.IsMigrating();
+            }
+            assert(migrated);
+            for (int i = 0; i < 1000; ++i) {
+                assert(v[i].id == i);
+            }
+            assert(v.end() - v.begin() == 1000);
+            assert(2 + v.begin() == v.begin() + 2 && v.cend() > v.begin() && v.cbegin() <= v.begin());
+            assert(v.end() >= v.cend() && v.cend() - v.begin() == 1000);
+            int sum = 0;
+            for (const Obj& obj : v) {
+                sum += obj.id;
+            }
+            assert(sum == 999 * 1000 / 2);
+            assert(Obj::GetAliveObjectCount() == 1000);
+
+            // Data() завершает перенос: элементы непрерывны
+            while (!v.IsMigrating()) {
+                v.EmplaceBack(0);
+            }
+            const Obj* data = v.Data();
+            assert(!v.IsMigrating() && data == &v[0] && data + 999 == &v[999]);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        IncrementalVector<std::string> v;
+        v.PushBack(std::string(40, 'a'));
+        while (!v.IsMigrating()) {
+            v.PushBack(std::string(40, 'b'));
+        }
+        // Аргумент может ссылаться на элемент, переносимый этим же добавлением
+        v.PushBack(v[0]);
+        assert(v[v.Size() - 1] == v[0] && v[0] == std::string(40, 'a'));
+
+        // Удаление вплоть до ещё не перенесённых элементов
+        v.PushBack("x");
+        v.PopBack();
+        while (v.IsMigrating()) {
+            v.PopBack();
+        }
+        assert(v.Size() > 0 && v[0] == std::string(40, 'a'));
+        const IncrementalVector<std::string> copy(v);
+        assert(copy.Size() == v.Size() && copy[0] == v[0]);
+        v.Clear();
+        assert(v.Size() == 0 && !v.IsMigrating());
+    }
+    {
+        SharedObj::ResetCounters();
+        {
+            IncrementalVector<SharedObj> v;
+            v.Resize(4);
+            v.EmplaceBack();
+            assert(v.IsMigrating() && v.PendingMigration() == 2);
+            // Элемент, копирование которого выбрасывает исключение, остаётся на месте
+            v[2].id = 2;
+            v[2].throw_on_copy = true;
+            try {
+                v.EmplaceBack();
+                assert(false);
+            }
+            catch (const std::runtime_error&) {
+            }
+            assert(v.Size() == 5 && v.PendingMigration() == 2 && v[2].id == 2);
+            assert(SharedObj::num_alive == 5);
+            v[2].throw_on_copy = false;
+            v.EmplaceBack();
+            assert(v.Size() == 6 && !v.IsMigrating() && v[2].id == 2);
+        }
+        assert(SharedObj::num_alive == 0);
+
+        // Исключение в конструкторе с размером разрушает уже созданные элементы
+        SharedObj::default_construction_throw_countdown = 5;
+        try {
+            IncrementalVector<SharedObj> v(8);
+            assert(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(SharedObj::num_alive == 0);
+        SharedObj::default_construction_throw_countdown = 0;
+    }
+}
+
+void Test28() {
+    const auto is_huge_page_aligned = [](const void* p) {
+        return reinterpret_cast<std::uintptr_t>(p) % HUGE_PAGE_BYTES == 0;
+    };
+    {
+        HugePageVector<int> v;
+        v.Reserve(1000);
+        assert(v.Capacity() == 1000);
+        // Большой буфер выровнен и округлён до огромных страниц
+        v.Reserve((3 << 20) / sizeof(int));
+        assert(is_huge_page_aligned(v.begin()));
+        assert(v.Capacity() == (4 << 20) / sizeof(int));
+        for (size_t i = 0; i < v.Capacity(); ++i) {
+            v.PushBack(static_cast<int>(i));
+        }
+        v.PushBack(-1);
+        assert(is_huge_page_aligned(v.begin()) && v[0] == 0 && v[v.Size() - 1] == -1);
+        v.ShrinkToFit();
+        assert(v[(4 << 20) / sizeof(int) - 1] == static_cast<int>((4 << 20) / sizeof(int) - 1));
+    }
+    {
+        // Страницы заполняются теми же потоками и частями, что и в параллельных операциях
+        const PlacementAllocator<double> alloc(Placement::OnNode(0));
+        const Vector<double, PlacementAllocator<double>> v(ParallelTag{ 2, 1 << 10 }, 1 << 20, alloc);
+        assert(is_huge_page_aligned(v.begin()) && v[(1 << 20) - 1] == 0.0);
+        assert(v.GetAllocator().GetPlacement().numa == NumaPolicy::BIND);
+        static_assert(Placement::OnNode(63).nodes == std::uint64_t{ 1 } << 63);
+        try {
+            Placement::OnNode(64);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::invalid_argument&) {
+        }
+
+        Vector<double, PlacementAllocator<double>> interleaved(PlacementAllocator<double>(Placement::Interleaved()));
+        interleaved = v;
+        assert(interleaved.Size() == v.Size() && is_huge_page_aligned(interleaved.begin()));
+        assert(interleaved.GetAllocator() == v.GetAllocator());
+        const PlacementAllocator<double> never_mapped(Placement{ std::numeric_limits<size_t>::max() });
+        assert(never_mapped != alloc);
+    }
+    {
+        Vector<Pixel, PlacementAllocator<Pixel>> pixels((1 << 20) / sizeof(Pixel));
+        assert(pixels.GetAllocator().GetPlacement().numa == NumaPolicy::INTERLEAVE);
+        assert(is_huge_page_aligned(pixels.begin()));
+        Vector<Pixel, PlacementAllocator<Pixel>> small(10);
+        assert(small.Capacity() == 10);
+    }
+}
+
+#if VECTOR_HAS_CONSTEXPR
+constexpr Vector<int> BuildSquares(int count) {
+    Vector<int> v;
+    for (int i = 0; i < count; ++i) {
+        v.PushBack(i * i);
+    }
+    return v;
+}
+
+constexpr auto SQUARES = ToArray<BuildSquares(16).Size()>(BuildSquares(16));
+static_assert(SQUARES.size() == 16 && SQUARES[15] == 225);
+
+// Возвращает номер первой не выполненной проверки или 0
+constexpr int CheckConstexprVector() {
+    Vector<int> ints = BuildSquares(8);
+    ints.Insert(ints.cbegin() + 2, -1);
+    ints.Emplace(ints.cbegin(), -2);
+    if (ints.Size() != 10 || ints[0] != -2 || ints[3] != -1 || ints[9] != 49) {
+        return 1;
+    }
+    ints.Erase(ints.cbegin(), ints.cbegin() + 2);
+    ints.Erase(ints.cbegin() + 1);
+    ints.Resize(12, ints[1]);
+    if (ints.Size() != 12 || ints[1] != 4 || ints[11] != 4) {
+        return 2;
+    }
+
+    Vector<std::string> strings;
+    strings.Reserve(2);
+    for (int i = 0; i < 5; ++i) {
+        strings.EmplaceBack(static_cast<size_t>(i + 20), static_cast<char>('a' + i));
+    }
+    strings.Insert(strings.cbegin() + 1, strings[4]);
+    strings.PushBack(strings[0]);
+    if (strings.Size() != 7 || strings[1] != strings[5] || strings[6] != strings[0]) {
+        return 3;
+    }
+    Vector<std::string> copy = strings;
+    strings.Erase(strings.cbegin());
+    strings.PopBack();
+    copy = strings;
+    Vector<std::string> moved = std::move(copy);
+    moved.ShrinkToFit();
+    if (moved.Size() != 5 || moved.Capacity() != 5 || moved[0] != std::string(24, 'e')) {
+        return 4;
+    }
+    moved.Swap(strings);
+    moved.Clear();
+
+    Vector<Vector<int>> nested(3);
+    nested[1] = ints;
+    nested.EmplaceBack(BuildSquares(3));
+    if (nested[1].Size() != 12 || nested[3][2] != 4) {
+        return 5;
+    }
+    return 0;
+}
+
+static_assert(CheckConstexprVector() == 0);
+#endif
+
+void Test29() {
+#if VECTOR_HAS_CONSTEXPR
+    // Те же операции во время выполнения идут по быстрым путям
+    assert(CheckConstexprVector() == 0);
+    const Vector<int> squares = BuildSquares(16);
+    for (size_t i = 0; i < SQUARES.size(); ++i) {
+        assert(SQUARES[i] == squares[i]);
+    }
+#endif
+    Vector<int> v(4);
+    v[2] = 3;
+    const auto table = ToArray<3>(v);
+    assert(table.size() == 3 && table[2] == 3);
+}
+
+void Test30() {
+    {
+        Vector<int> elements(4);
+        for (size_t i = 0; i < elements.Size(); ++i) {
+            elements[i] = static_cast<int>(i);
+        }
+        CowVector<int> v(std::move(elements));
+        CowVector<int> copy = v;
+        // Копия разделяет буфер, чтение через константную ссылку его не копирует
+        assert(copy.UseCount() == 2 && copy.View().begin() == v.View().begin());
+        const CowVector<int>& const_copy = copy;
+        assert(const_copy[3] == 3 && copy.UseCount() == 2);
+
+        copy[0] = 10;
+        assert(copy.UseCount() == 1 && v.UseCount() == 1);
+        assert(v[0] == 0 && copy[0] == 10 && copy.Size() == 4);
+
+        CowVector<int> snapshot = v;
+        v.PushBack(v[3]);
+        v.Erase(v.cbegin());
+        assert(v.Size() == 4 && v[0] == 1 && v[3] == 3);
+        assert(snapshot.Size() == 4 && snapshot[0] == 0);
+
+        snapshot = v;
+        snapshot.Clear();
+        assert(snapshot.Size() == 0 && snapshot.UseCount() == 0 && v.Size() == 4);
+        snapshot.Insert(snapshot.cbegin(), 5);
+        assert(snapshot.Size() == 1 && snapshot[0] == 5);
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj> elements(3);
+        elements[2].throw_on_copy = true;
+        CowVector<Obj> v(std::move(elements));
+        CowVector<Obj> copy = v;
+        try {
+            copy.EmplaceBack(1);
+            assert(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+        // Буфер по-прежнему разделён и не изменился
+        assert(copy.UseCount() == 2 && copy.Size() == 3);
+        assert(Obj::GetAliveObjectCount() == 3);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        AtomicCowVector<int> current;
+        assert(current.Load().Size() == 0);
+        CowVector<int> version;
+        version.Resize(2);
+        current.Store(version);
+        CowVector<int> snapshot = current.Load();
+        assert(snapshot.UseCount() == 3 && snapshot.Size() == 2);
+        version.PushBack(1);
+        CowVector<int> previous = current.Exchange(version);
+        assert(previous.Size() == 2 && current.Load().Size() == 3);
+        assert(previous.View().begin() == snapshot.View().begin());
+    }
+    {
+        // Писатель публикует версии, читатели берут снимки без блокировок
+        constexpr int VERSIONS = 500;
+        AtomicCowVector<int> current;
+        std::atomic<bool> done{ false };
+        std::vector<std::thread> readers;
+        for (int r = 0; r < 2; ++r) {
+            readers.emplace_back([&] {
+                size_t last_size = 0;
+                while (!done.load()) {
+                    const CowVector<int> snapshot = current.Load();
+                    // Каждая версия содержит 0, 1, ..., n - 1
+                    assert(snapshot.Size() >= last_size);
+                    for (size_t i = 0; i < snapshot.Size(); ++i) {
+                        assert(snapshot[i] == static_cast<int>(i));
+                    }
+                    last_size = snapshot.Size();
+                }
+            });
+        }
+        CowVector<int> version;
+        for (int i = 0; i < VERSIONS; ++i) {
+            version.PushBack(i);
+            current.Store(version);
+        }
+        done = true;
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        assert(current.Load().Size() == static_cast<size_t>(VERSIONS));
+    }
+}
+
+void Test31() {
+    {
+        Vector<int> keys(6);
+        const int values[] = { 5, 1, 4, 1, 5, 9 };
+        std::copy(std::begin(values), std::end(values), keys.begin());
+        const int* buffer = keys.begin();
+        // Сортировка и удаление повторов на месте, без новой памяти
+        FlatSet<int> set(std::move(keys));
+        assert(set.Size() == 4 && set.Keys().begin() == buffer);
+        assert(std::is_sorted(set.begin(), set.end()));
+        assert(set.Contains(4) && !set.Contains(2) && set.Find(9) == set.end() - 1);
+        assert(*set.LowerBound(2) == 4 && set.UpperBound(9) == set.end());
+
+        assert(!set.Insert(5).second && set.Insert(2).second && set.Size() == 5);
+        set.InsertMany({ 8, 0, 3, 9, 3, 10 });
+        const int expected[] = { 0, 1, 2, 3, 4, 5, 8, 9, 10 };
+        assert(std::equal(set.begin(), set.end(), std::begin(expected), std::end(expected)));
+        assert(set.EraseIf([](int key) {
+            return key % 2 != 0;
+        }) == 4);
+        assert(set.Erase(4) == 1 && set.Erase(4) == 0 && set.Size() == 4);
+    }
+    {
+        // Поиск по индексу Эйтцингера совпадает с обычным двоичным поиском
+        for (int size : { 0, 1, 2, 7, 8, 100, 1023, 1024 }) {
+            Vector<int> keys;
+            for (int i = 0; i < size; ++i) {
+                keys.PushBack(i * 2);
+            }
+            FlatSet<int> set(std::move(keys));
+            set.BuildSearchIndex();
+            assert(set.HasSearchIndex() == (size != 0));
+            for (int key = -1; key <= size * 2 + 1; ++key) {
+                assert(set.LowerBound(key) == std::lower_bound(set.begin(), set.end(), key));
+                assert(set.Contains(key) == (key >= 0 && key < size * 2 && key % 2 == 0));
+            }
+            set.Insert(-5);
+            assert(!set.HasSearchIndex() && *set.begin() == -5);
+        }
+    }
+    {
+        FlatSet<int, std::greater<int>> set({ 1, 3, 2 });
+        set.InsertMany({ 0, 4 });
+        assert(*set.begin() == 4 && *(set.end() - 1) == 0);
+    }
+    {
+        // Из пар с равными ключами остаётся первая, как в std::map
+        FlatMap<int, std::string> map({ { 3, "c" }, { 1, "a" }, { 3, "x" }, { 2, "b" } });
+        assert(map.Size() == 3 && map.At(3) == "c");
+        assert(std::is_sorted(map.Keys().begin(), map.Keys().end()));
+        map[4] = "d";
+        assert(map.Size() == 4 && map.Find(4)->second == "d");
+        assert(!map.Insert(1, "z").second && map.At(1) == "a");
+        assert(!map.InsertOrAssign(1, "z").second && map.At(1) == "z");
+        try {
+            map.At(10);
+            assert(false);
+        }
+        catch (const std::out_of_range&) {
+        }
+
+        std::map<int, std::string> reference;
+        for (const auto& [key, value] : map) {
+            reference.emplace(key, value);
+        }
+        Vector<std::pair<int, std::string>> batch;
+        for (int i = 0; i < 20; i += 3) {
+            batch.PushBack({ i, std::to_string(i) });
+            reference.emplace(i, std::to_string(i));
+        }
+        map.InsertMany(batch.begin(), batch.end());
+        assert(map.Size() == reference.size());
+        assert(std::equal(map.begin(), map.end(), reference.begin(), [](const auto& lhs, const auto& rhs) {
+            return lhs.first == rhs.first && lhs.second == rhs.second;
+        }));
+
+        assert(map.EraseIf([](int key, std::string& value) {
+            return key % 2 == 0 || value == "z";
+        }) == 7);
+        assert(map.Size() == 3 && map.At(3) == "c" && map.At(9) == "9");
+        map.BuildSearchIndex();
+        assert(map.Contains(15) && !map.Contains(16));
+        assert(map.Erase(15) == 1 && !map.HasSearchIndex() && !map.Contains(15));
+        for (auto [key, value] : map) {
+            value += "!";
+            static_cast<void>(key);
+        }
+        assert(map.At(3) == "c!" && map.Values()[0] == "c!");
+
+        // iterator и const_iterator сравниваются между собой
+        using Iterator = FlatMap<int, std::string>::iterator;
+        static_assert(std::is_same_v<std::iterator_traits<Iterator>::iterator_category,
+            std::random_access_iterator_tag>);
+        const Iterator found = map.Find(9);
+        assert(found != map.cend() && map.cbegin() != found && found - map.cbegin() == 1);
+        assert(map.Find(16) == map.cend() && map.cend() == map.Find(16));
+        assert(map.cbegin() < found && found > map.cbegin() && found <= map.cend() && map.cend() >= found);
+        assert(1 + map.begin() == found && (1 + map.cbegin())->second == "9!");
+    }
+}
+
+void Test32() {
+    WorkStealingPool pool(4);
+    assert(pool.Concurrency() == 4);
+    {
+        // Вложенные Invoke: ожидающие потоки выполняют чужие задачи
+        std::function<long(int)> fib = [&](int n) -> long {
+            if (n < 2) {
+                return n;
+            }
+            long a = 0;
+            long b = 0;
+            pool.Invoke([&] { a = fib(n - 1); }, [&] { b = fib(n - 2); });
+            return a + b;
+        };
+        assert(fib(20) == 6765);
+        try {
+            pool.Invoke([] {}, [] { throw std::runtime_error("second"); });
+            assert(false);
+        }
+        catch (const std::runtime_error& e) {
+            assert(std::string(e.what()) == "second");
+        }
+    }
+    ParallelExecutor executor(pool, 64);
+    {
+        constexpr size_t SIZE = 100000;
+        Vector<int> v(SIZE);
+        unsigned seed = 1;
+        for (int& x : v) {
+            seed = seed * 1664525u + 1013904223u;
+            x = static_cast<int>(seed >> 8) % 1000;
+        }
+        std::vector<int> expected(v.begin(), v.end());
+        std::sort(expected.begin(), expected.end());
+        executor.Sort(v.begin(), v.end());
+        assert(std::equal(v.begin(), v.end(), expected.begin(), expected.end()));
+        const size_t scratch = executor.ScratchBytes();
+        assert(scratch >= SIZE * sizeof(int));
+        executor.Sort(v.begin(), v.end(), std::greater<>());
+        assert(std::is_sorted(v.begin(), v.end(), std::greater<>()));
+        // Буфер переиспользуется, а не выделяется заново
+        assert(executor.ScratchBytes() == scratch);
+
+        Vector<std::string> strings(5000);
+        for (size_t i = 0; i < strings.Size(); ++i) {
+            strings[i] = std::to_string((i * 7919) % strings.Size()) + std::string(20, 'x');
+        }
+        executor.Sort(strings.begin(), strings.end());
+        assert(std::is_sorted(strings.begin(), strings.end()) && strings[0] == "0" + std::string(20, 'x'));
+
+        try {
+            executor.Sort(strings.begin(), strings.end(), [](const std::string&, const std::string&) -> bool {
+                throw std::runtime_error("comp");
+            });
+            assert(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(strings.Size() == 5000);
+    }
+    {
+        Vector<int> v(10000);
+        std::iota(v.begin(), v.end(), 1);
+        Vector<long> squares(v.Size());
+        executor.Transform(v.begin(), v.end(), squares.begin(), [](int x) {
+            return static_cast<long>(x) * x;
+        });
+        assert(squares[9999] == 100000000L);
+        assert(executor.Reduce(v.begin(), v.end(), 0L) == 50005000L);
+        // Порядок частей сохраняется: конкатенация не коммутативна
+        Vector<std::string> digits(1000);
+        for (size_t i = 0; i < digits.Size(); ++i) {
+            digits[i] = std::to_string(i % 10);
+        }
+        const std::string joined = executor.Reduce(digits.begin(), digits.end(), std::string(">"));
+        assert(joined.size() == 1001 && joined.substr(0, 11) == ">0123456789");
+
+        Vector<long> prefix(v.Size());
+        executor.ExclusiveScan(v.begin(), v.end(), prefix.begin(), 0L);
+        assert(prefix[0] == 0 && prefix[9999] == 49995000L);
+        executor.InclusiveScan(v.begin(), v.end(), v.begin());
+        assert(v[0] == 1 && v[99] == 5050 && v[9999] == 50005000);
+    }
+    {
+        Vector<std::pair<int, std::string>> items(3000);
+        for (size_t i = 0; i < items.Size(); ++i) {
+            items[i] = { static_cast<int>(i), std::to_string(i) };
+        }
+        auto* middle = executor.StablePartition(items.begin(), items.end(), [](const auto& item) {
+            return item.first % 3 == 0;
+        });
+        assert(middle - items.begin() == 1000);
+        for (size_t i = 0; i < items.Size(); ++i) {
+            const int expected = i < 1000 ? static_cast<int>(i * 3) : static_cast<int>((i - 1000) / 2 * 3 + 1 + (i - 1000) % 2);
+            assert(items[i].first == expected && items[i].second == std::to_string(expected));
+        }
+        executor.ReleaseScratch();
+        assert(executor.ScratchBytes() == 0);
+
+        // Перемещение может бросить исключение: разбиение выполняет std::stable_partition
+        struct MoveOnly {
+            explicit MoveOnly(int value)
+                : value(value) {
+            }
+            MoveOnly(MoveOnly&& other)
+                : value(other.value) {
+                if (value < 0) {
+                    throw std::runtime_error("move");
+                }
+            }
+            MoveOnly& operator=(MoveOnly&& other) {
+                if (other.value < 0) {
+                    throw std::runtime_error("move");
+                }
+                value = other.value;
+                return *this;
+            }
+            int value;
+        };
+        Vector<MoveOnly> moveonly;
+        for (int i = 0; i < 1000; ++i) {
+            moveonly.EmplaceBack(i);
+        }
+        const MoveOnly* split = executor.StablePartition(moveonly.begin(), moveonly.end(), [](const MoveOnly& x) {
+            return x.value % 2 == 1;
+        });
+        assert(split - moveonly.begin() == 500 && moveonly[0].value == 1 && moveonly[500].value == 0);
+        moveonly[700].value = -1;
+        try {
+            executor.StablePartition(moveonly.begin(), moveonly.end(), [](const MoveOnly& x) {
+                return x.value % 2 == 0;
+            });
+            assert(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+    }
+    {
+        // Задача, украденная во время ожидания внутри Sort, сортирует свой диапазон
+        // со своим буфером, а не с буфером внешней сортировки того же потока
+        constexpr size_t BUCKETS = 64;
+        constexpr size_t BUCKET_SIZE = 2000;
+        Vector<int> v(BUCKETS * BUCKET_SIZE);
+        unsigned seed = 7;
+        for (int& x : v) {
+            seed = seed * 1664525u + 1013904223u;
+            x = static_cast<int>(seed >> 8) % 100000;
+        }
+        // Вложенный вызов того же исполнителя не трогает буфер внешнего
+        Vector<int> inner;
+        inner.Assign(v.begin(), v.begin() + 20000);
+        Vector<int> keys(3000);
+        std::iota(keys.begin(), keys.end(), 0);
+        executor.StablePartition(keys.begin(), keys.end(), [&](int key) {
+            if (key == 0) {
+                executor.Sort(inner.begin(), inner.end());
+            }
+            return key % 2 == 1;
+        });
+        assert(std::is_sorted(inner.begin(), inner.end()));
+        for (size_t i = 0; i < keys.Size(); ++i) {
+            assert(keys[i] == static_cast<int>(i < 1500 ? i * 2 + 1 : (i - 1500) * 2));
+        }
+
+        ParallelExecutor outer(pool, 1);
+        outer.For(BUCKETS, [&](size_t begin, size_t end) {
+            thread_local ParallelExecutor inner(pool, 64);
+            for (size_t bucket = begin; bucket < end; ++bucket) {
+                inner.Sort(v.begin() + bucket * BUCKET_SIZE, v.begin() + (bucket + 1) * BUCKET_SIZE);
+            }
+        });
+        for (size_t bucket = 0; bucket < BUCKETS; ++bucket) {
+            assert(std::is_sorted(v.begin() + bucket * BUCKET_SIZE, v.begin() + (bucket + 1) * BUCKET_SIZE));
+        }
+    }
+    {
+        // Функции Parallel* пользуются исполнителем потока на общем пуле
+        Vector<double> v(1000);
+        for (size_t i = 0; i < v.Size(); ++i) {
+            v[i] = static_cast<double>(v.Size() - i);
+        }
+        ParallelSort(v.begin(), v.end());
+        assert(v[0] == 1.0 && v[999] == 1000.0);
+        assert(ParallelReduce(v.begin(), v.end(), 0.0) == 500500.0);
+        ParallelTransform(v.begin(), v.end(), v.begin(), [](double x) {
+            return -x;
+        });
+        ParallelInclusiveScan(v.begin(), v.end(), v.begin());
+        assert(v[999] == -500500.0);
+        Vector<int> ids(100);
+        std::iota(ids.begin(), ids.end(), 0);
+        ParallelExclusiveScan(ids.begin(), ids.end(), ids.begin(), 0);
+        assert(ids[99] == 4851);
+        assert(ParallelStablePartition(ids.begin(), ids.end(), [](int x) { return x % 2 == 0; }) == ids.begin() + 50);
+    }
+}
+
+void Test33() {
+#ifndef VECTOR_HEAP_PROFILE
+    // Без профиля место вызова не хранится, а выделения не записываются
+    static_assert(sizeof(Vector<int>) == sizeof(int*) + 2 * sizeof(size_t));
+    {
+        Vector<int> v(100);
+        v.Reserve(1000);
+    }
+    assert(HeapProfiler::Instance().Snapshot().empty());
+#else
+    HeapProfiler& profiler = HeapProfiler::Instance();
+    profiler.Reset();
+    auto find = [&](unsigned line) {
+        for (const HeapProfileSite& site : profiler.Snapshot()) {
+            if (site.file != nullptr && std::string(site.file) == __FILE__ && site.line == line) {
+                return site;
+            }
+        }
+        return HeapProfileSite{};
+    };
+    unsigned created = 0;
+    unsigned reserved_line = 0;
+    unsigned pushed_line = 0;
+    {
+        // Рост в EmplaceBack приписывается месту создания вектора
+        Vector<int> grown; created = __LINE__;
+        for (int i = 0; i < 100; ++i) {
+            grown.EmplaceBack(i);
+        }
+        HeapProfileSite site = find(created);
+        assert(site.allocations == 8 && site.reallocations == 7);
+        assert(site.live_blocks == 1 && site.live_capacity == 128 && site.live_bytes == 128 * sizeof(int));
+        // Во время переноса живы оба буфера
+        assert(site.peak_capacity == 128 && site.peak_bytes == (64 + 128) * sizeof(int));
+
+        Vector<int> reserved;
+        reserved.Reserve(100); reserved_line = __LINE__;
+        for (int i = 0; i < 100; ++i) {
+            reserved.PushBack(i);
+        }
+        site = find(reserved_line);
+        assert(site.allocations == 1 && site.reallocations == 0 && site.peak_capacity == 100);
+
+        reserved.PushBack(100); pushed_line = __LINE__;
+        site = find(pushed_line);
+        assert(site.allocations == 1 && site.reallocations == 1 && site.live_capacity == 200);
+        assert(find(reserved_line).live_blocks == 0);
+
+        // Методы, вызванные внутри Resize, пишут место вызова Resize
+        Vector<int> resized; const unsigned resized_created = __LINE__;
+        resized.Resize(10); const unsigned resized_line = __LINE__;
+        assert(find(resized_line).allocations == 1 && find(resized_created).allocations == 0);
+    }
+    {
+        // Неудачный перенос блока не снимает старый блок с учёта
+        auto unknown = [&] {
+            for (const HeapProfileSite& site : profiler.Snapshot()) {
+                if (site.file == nullptr) {
+                    return site;
+                }
+            }
+            return HeapProfileSite{};
+        };
+        RawMemory<int, MallocAllocator<int>> memory(16);
+        const HeapProfileSite before = unknown();
+        try {
+            memory.Reallocate(std::numeric_limits<size_t>::max() / sizeof(int) + 1);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::bad_alloc&) {
+        }
+        assert(unknown().live_blocks == before.live_blocks && unknown().live_bytes == before.live_bytes);
+        memory.Reallocate(32);
+        assert(unknown().live_blocks == before.live_blocks && unknown().live_capacity == before.live_capacity + 16);
+    }
+    // Разрушенные векторы не держат память, пик сохраняется
+    assert(find(created).live_bytes == 0 && find(created).peak_bytes == (64 + 128) * sizeof(int));
+    assert(find(pushed_line).live_blocks == 0);
+
+    std::ostringstream report;
+    profiler.WriteReport(report);
+    const std::string text = report.str();
+    const std::string top = std::string(__FILE__) + ":" + std::to_string(pushed_line);
+    assert(text.find(top) != std::string::npos);
+    assert(text.find(top) < text.find(std::string(__FILE__) + ":" + std::to_string(created)));
+
+    std::ostringstream pprof;
+    profiler.WritePprof(pprof);
+    const std::string profile = pprof.str();
+    assert(!profile.empty() && profile[0] == '\x0a');
+    assert(profile.find("inuse_space") != std::string::npos);
+    assert(profile.find(__FILE__) != std::string::npos);
+#endif
 }
 
 int main() {
@@ -654,7 +3066,33 @@ int main() {
         Test4();
         Test5();
         Test6();
-        Benchmark();
+        Test7();
+        Test8();
+        Test9();
+        Test10();
+        Test11();
+        Test12();
+        Test13();
+        Test14();
+        Test15();
+        Test16();
+        Test17();
+        Test18();
+        Test19();
+        Test20();
+        Test21();
+        Test22();
+        Test23();
+        Test24();
+        Test25();
+        Test26();
+        Test27();
+        Test28();
+        Test29();
+        Test30();
+        Test31();
+        Test32();
+        Test33();
     }
     catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
@@ -0,0 +1,283 @@
+#pragma once
+#include "vector.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+// Вектор, элементы которого хранятся в отображённом в память файле (POSIX). Файл начинается
+// с заголовка, в котором записаны тип элементов и размер вектора, поэтому после перезапуска
+// файл открывается без разбора содержимого, а страницы подгружаются ОС по мере обращения.
+// Все изменения сразу попадают в файл; Sync() дожидается их записи на диск.
+// Вместимость растёт через ftruncate и mremap, поэтому элементы должны быть тривиально копируемыми.
+template <typename T, typename Growth = DoublingGrowth>
+class MappedVector {
+	static constexpr size_t HEADER_BYTES = 64;
+
+	static_assert(std::is_trivially_copyable_v<T>, "MappedVector requires a trivially copyable T");
+	static_assert(alignof(T) <= HEADER_BYTES);
+
+	struct Header {
+		std::uint64_t magic;
+		std::uint32_t version;
+		std::uint32_t element_size;
+		std::uint64_t size;
+	};
+
+	static constexpr std::uint64_t MAGIC = 0x524f544345564d41;  // "AMVECTOR"
+	static constexpr std::uint32_t VERSION = 1;
+
+public:
+	using iterator = T*;
+	using const_iterator = const T*;
+
+	// Открывает ранее сохранённый вектор или создаёт пустой, если файла нет
+	static MappedVector Open(const std::string& path) {
+		MappedVector v(OpenFile(path, O_RDWR | O_CREAT));
+		v.Load();
+		return v;
+	}
+
+	// Создаёт пустой вектор, удаляя прежнее содержимое файла
+	static MappedVector Create(const std::string& path) {
+		MappedVector v(OpenFile(path, O_RDWR | O_CREAT | O_TRUNC));
+		v.Load();
+		return v;
+	}
+
+	MappedVector(const MappedVector&) = delete;
+	MappedVector& operator=(const MappedVector&) = delete;
+
+	// Перемещённый вектор пуст и не связан с файлом: Size() и Capacity() возвращают 0
+	MappedVector(MappedVector&& other) noexcept
+		: fd_(std::exchange(other.fd_, -1))
+		, map_(std::exchange(other.map_, nullptr))
+		, length_(std::exchange(other.length_, 0)) {
+	}
+
+	MappedVector& operator=(MappedVector&& rhs) noexcept {
+		if (this != &rhs) {
+			Close();
+			fd_ = std::exchange(rhs.fd_, -1);
+			map_ = std::exchange(rhs.map_, nullptr);
+			length_ = std::exchange(rhs.length_, 0);
+		}
+		return *this;
+	}
+
+	~MappedVector() {
+		Close();
+	}
+
+	iterator begin() noexcept {
+		return Data();
+	}
+	iterator end() noexcept {
+		return Data() + Size();
+	}
+	const_iterator begin() const noexcept {
+		return Data();
+	}
+	const_iterator end() const noexcept {
+		return Data() + Size();
+	}
+
+	size_t Size() const noexcept {
+		return map_ != nullptr ? GetHeader().size : 0;
+	}
+
+	size_t Capacity() const noexcept {
+		return map_ != nullptr ? (length_ - HEADER_BYTES) / sizeof(T) : 0;
+	}
+
+	const T& operator[](size_t index) const noexcept {
+		return const_cast<MappedVector&>(*this)[index];
+	}
+
+	T& operator[](size_t index) noexcept {
+		assert(index < Size());
+		return Data()[index];
+	}
+
+	// Увеличивает файл и отображение. При ошибке выбрасывает std::system_error,
+	// содержимое вектора при этом не меняется.
+	void Reserve(size_t capacity) {
+		if (capacity <= Capacity()) {
+			return;
+		}
+		if (capacity > (std::numeric_limits<off_t>::max() - HEADER_BYTES) / sizeof(T)) {
+			throw std::length_error("MappedVector capacity is too large");
+		}
+		const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+		const size_t length = (HEADER_BYTES + capacity * sizeof(T) + page - 1) / page * page;
+		if (::ftruncate(fd_, static_cast<off_t>(length)) != 0) {
+			ThrowSystemError("ftruncate");
+		}
+		Remap(length);
+	}
+
+	void Resize(size_t new_size) {
+		Resize(new_size, T{});
+	}
+
+	void Resize(size_t new_size, const T& value) {
+		const T tmp(value);
+		const size_t size = Size();
+		if (new_size == size) {
+			return;
+		}
+		if (new_size > size) {
+			Reserve(new_size);
+			std::uninitialized_fill(Data() + size, Data() + new_size, tmp);
+		}
+		GetHeader().size = new_size;
+	}
+
+	template <typename... Args>
+	T& EmplaceBack(Args&&... args) {
+		// Аргументы могут ссылаться на элементы, которые переедут при переотображении
+		const T tmp(std::forward<Args>(args)...);
+		const size_t size = Size();
+		if (size == Capacity()) {
+			Reserve(Growth::NextCapacity(Capacity(), sizeof(T)));
+		}
+		T* elem = new(Data() + size) T(tmp);
+		GetHeader().size = size + 1;
+		return *elem;
+	}
+
+	void PushBack(const T& value) {
+		EmplaceBack(value);
+	}
+
+	void PopBack() noexcept {
+		assert(Size() != 0);
+		--GetHeader().size;
+	}
+
+	void Clear() noexcept {
+		if (map_ != nullptr) {
+			GetHeader().size = 0;
+		}
+	}
+
+	// Дожидается записи изменённых страниц в файл
+	void Sync() {
+		if (map_ == nullptr) {
+			return;
+		}
+		if (::msync(map_, length_, MS_SYNC) != 0) {
+			ThrowSystemError("msync");
+		}
+	}
+
+private:
+	explicit MappedVector(int fd) noexcept
+		: fd_(fd) {
+	}
+
+	[[noreturn]] static void ThrowSystemError(const char* what) {
+		throw std::system_error(errno, std::generic_category(), what);
+	}
+
+	static int OpenFile(const std::string& path, int flags) {
+		const int fd = ::open(path.c_str(), flags | O_CLOEXEC, 0644);
+		if (fd < 0) {
+			ThrowSystemError("open");
+		}
+		return fd;
+	}
+
+	// Отображает открытый файл; пустой файл получает заголовок
+	void Load() {
+		struct stat st {};
+		if (::fstat(fd_, &st) != 0) {
+			ThrowSystemError("fstat");
+		}
+		const size_t file_size = static_cast<size_t>(st.st_size);
+		if (file_size == 0) {
+			const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+			if (::ftruncate(fd_, static_cast<off_t>(page)) != 0) {
+				ThrowSystemError("ftruncate");
+			}
+			Remap(page);
+			GetHeader() = Header{ MAGIC, VERSION, static_cast<std::uint32_t>(sizeof(T)), 0 };
+			return;
+		}
+		if (file_size < HEADER_BYTES) {
+			throw std::runtime_error("MappedVector file is truncated");
+		}
+		Remap(file_size);
+		const Header& header = GetHeader();
+		if (header.magic != MAGIC || header.version != VERSION) {
+			throw std::runtime_error("Not a MappedVector file");
+		}
+		if (header.element_size != sizeof(T)) {
+			throw std::runtime_error("MappedVector file holds elements of a different size");
+		}
+		if (header.size > Capacity()) {
+			throw std::runtime_error("MappedVector file is truncated");
+		}
+	}
+
+	void Remap(size_t length) {
+		void* address = nullptr;
+		if (map_ == nullptr) {
+			address = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+		}
+		else {
+#ifdef MREMAP_MAYMOVE
+			address = ::mremap(map_, length_, length, MREMAP_MAYMOVE);
+#else
+			address = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+			if (address != MAP_FAILED) {
+				::munmap(map_, length_);
+			}
+#endif
+		}
+		if (address == MAP_FAILED) {
+			ThrowSystemError("mmap");
+		}
+		map_ = static_cast<unsigned char*>(address);
+		length_ = length;
+	}
+
+	void Close() noexcept {
+		if (map_ != nullptr) {
+			::munmap(map_, length_);
+			map_ = nullptr;
+		}
+		if (fd_ >= 0) {
+			::close(fd_);
+			fd_ = -1;
+		}
+	}
+
+	Header& GetHeader() noexcept {
+		return *reinterpret_cast<Header*>(map_);
+	}
+
+	const Header& GetHeader() const noexcept {
+		return *reinterpret_cast<const Header*>(map_);
+	}
+
+	T* Data() noexcept {
+		return map_ != nullptr ? reinterpret_cast<T*>(map_ + HEADER_BYTES) : nullptr;
+	}
+
+	const T* Data() const noexcept {
+		return map_ != nullptr ? reinterpret_cast<const T*>(map_ + HEADER_BYTES) : nullptr;
+	}
+
+	int fd_ = -1;
+	unsigned char* map_ = nullptr;
+	size_t length_ = 0;
+};
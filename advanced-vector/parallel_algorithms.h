@@ -0,0 +1,601 @@
+#pragma once
+#include "vector.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+// Пул потоков с кражей задач для параллелизма вида fork-join. У каждого рабочего потока своя
+// очередь: новые задачи кладутся в её конец и оттуда же забираются, поэтому поток сначала
+// доделывает самую свежую (и самую мелкую) работу, а простаивающие потоки крадут самые старые,
+// крупные задачи из начала чужих очередей. Потоки, не принадлежащие пулу, пользуются общей
+// очередью. Ожидающий поток не блокируется, а выполняет чужие задачи, поэтому вложенные
+// Invoke не приводят к взаимоблокировке.
+class WorkStealingPool {
+	struct Task {
+		void (*run)(void*) noexcept;
+		void* context;
+	};
+
+	struct alignas(CACHE_LINE_BYTES) Queue {
+		std::mutex mutex;
+		Vector<Task> tasks;
+	};
+
+	struct Worker {
+		const WorkStealingPool* pool = nullptr;
+		size_t queue = 0;
+	};
+
+public:
+	// threads — число потоков вместе с вызывающим; 0 — std::thread::hardware_concurrency()
+	explicit WorkStealingPool(size_t threads = 0)
+		: worker_count_((threads != 0 ? threads : std::max<size_t>(std::thread::hardware_concurrency(), 1)) - 1)
+		, queues_(new Queue[worker_count_ + 1]) {
+		workers_.Reserve(worker_count_);
+		try {
+			for (size_t i = 0; i < worker_count_; ++i) {
+				workers_.EmplaceBack([this, i] {
+					Run(i);
+				});
+			}
+		}
+		catch (...) {
+			Stop();
+			throw;
+		}
+	}
+
+	WorkStealingPool(const WorkStealingPool&) = delete;
+	WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+	~WorkStealingPool() {
+		Stop();
+	}
+
+	// Общий пул на все ядра машины
+	static WorkStealingPool& Default() {
+		static WorkStealingPool pool;
+		return pool;
+	}
+
+	size_t Concurrency() const noexcept {
+		return worker_count_ + 1;
+	}
+
+	// Выполняет first и second, возможно параллельно, и возвращает управление, когда завершатся
+	// обе. second может быть украдена другим потоком. Собственных исключений Invoke не бросает;
+	// если обе функции выбросили исключение, пробрасывается исключение first.
+	template <typename First, typename Second>
+	void Invoke(First&& first, Second&& second) {
+		if (worker_count_ == 0) {
+			first();
+			second();
+			return;
+		}
+		struct Job {
+			std::remove_reference_t<Second>* fn = nullptr;
+			std::atomic<bool> done{ false };
+			std::exception_ptr error;
+		};
+		Job job;
+		job.fn = &second;
+		try {
+			Push(Task{ [](void* context) noexcept {
+				Job& job = *static_cast<Job*>(context);
+				try {
+					(*job.fn)();
+				}
+				catch (...) {
+					job.error = std::current_exception();
+				}
+				job.done.store(true, std::memory_order_release);
+			}, &job });
+		}
+		catch (...) {
+			// Очередь не смогла вырасти: обе функции выполняются здесь же
+			first();
+			second();
+			return;
+		}
+		std::exception_ptr error;
+		try {
+			first();
+		}
+		catch (...) {
+			error = std::current_exception();
+		}
+		// Задача ссылается на second и job в этом кадре стека: ждать её нужно в любом случае
+		while (!job.done.load(std::memory_order_acquire)) {
+			if (!RunOne()) {
+				std::this_thread::yield();
+			}
+		}
+		if (error) {
+			std::rethrow_exception(error);
+		}
+		if (job.error) {
+			std::rethrow_exception(job.error);
+		}
+	}
+
+private:
+	static Worker& CurrentWorker() noexcept {
+		thread_local Worker worker;
+		return worker;
+	}
+
+	size_t LocalQueue() const noexcept {
+		const Worker& worker = CurrentWorker();
+		return worker.pool == this ? worker.queue : worker_count_;
+	}
+
+	void Push(const Task& task) {
+		Queue& queue = queues_[LocalQueue()];
+		{
+			std::lock_guard lock(queue.mutex);
+			queue.tasks.PushBack(task);
+		}
+		pending_.fetch_add(1);
+		if (sleeping_.load() != 0) {
+			// Под мьютексом уведомление не потеряется между проверкой условия и засыпанием
+			std::lock_guard lock(sleep_mutex_);
+			wake_.notify_one();
+		}
+	}
+
+	// Берёт последнюю задачу своей очереди или крадёт первую из чужой
+	bool RunOne() noexcept {
+		const size_t count = worker_count_ + 1;
+		const size_t own = LocalQueue();
+		for (size_t i = 0; i < count; ++i) {
+			Queue& queue = queues_[(own + i) % count];
+			std::unique_lock lock(queue.mutex);
+			if (queue.tasks.Size() == 0) {
+				continue;
+			}
+			Task task{};
+			if (i == 0) {
+				task = queue.tasks[queue.tasks.Size() - 1];
+				queue.tasks.PopBack();
+			}
+			else {
+				task = queue.tasks[0];
+				queue.tasks.Erase(queue.tasks.cbegin());
+			}
+			lock.unlock();
+			pending_.fetch_sub(1);
+			task.run(task.context);
+			return true;
+		}
+		return false;
+	}
+
+	void Run(size_t index) noexcept {
+		CurrentWorker() = Worker{ this, index };
+		while (true) {
+			if (RunOne()) {
+				continue;
+			}
+			std::unique_lock lock(sleep_mutex_);
+			sleeping_.fetch_add(1);
+			wake_.wait(lock, [this] {
+				return stop_ || pending_.load() != 0;
+			});
+			sleeping_.fetch_sub(1);
+			if (stop_) {
+				return;
+			}
+		}
+	}
+
+	void Stop() noexcept {
+		{
+			std::lock_guard lock(sleep_mutex_);
+			stop_ = true;
+		}
+		wake_.notify_all();
+		for (std::thread& worker : workers_) {
+			worker.join();
+		}
+		workers_.Clear();
+	}
+
+	const size_t worker_count_;
+	std::unique_ptr<Queue[]> queues_;  // последняя очередь — для потоков вне пула
+	Vector<std::thread> workers_;
+	std::atomic<size_t> pending_{ 0 };
+	std::atomic<size_t> sleeping_{ 0 };
+	std::mutex sleep_mutex_;
+	std::condition_variable wake_;
+	bool stop_ = false;
+};
+
+// Параллельные алгоритмы над диапазонами с произвольным доступом (итераторы Vector,
+// VectorView, указатели) поверх WorkStealingPool. Диапазон делится пополам, пока части
+// длиннее min_chunk, и половины выполняются через Invoke. Вспомогательный буфер сортировки
+// и разбиения хранится в исполнителе и переиспользуется между вызовами, а вложенный вызов
+// на том же потоке получает собственный буфер. Один исполнитель нельзя вызывать одновременно
+// из нескольких потоков.
+class ParallelExecutor {
+public:
+	explicit ParallelExecutor(WorkStealingPool& pool = WorkStealingPool::Default(),
+		size_t min_chunk = PARALLEL.min_chunk)
+		: pool_(pool)
+		, min_chunk_(std::max<size_t>(min_chunk, 1)) {
+	}
+
+	// Исполнитель текущего потока на общем пуле: им пользуются функции Parallel*
+	static ParallelExecutor& Local() {
+		thread_local ParallelExecutor executor;
+		return executor;
+	}
+
+	WorkStealingPool& GetPool() const noexcept {
+		return pool_;
+	}
+
+	// Вызывает fn(first, last) для частей диапазона [0, count) не длиннее min_chunk
+	template <typename Fn>
+	void For(size_t count, Fn fn) {
+		ForRange(0, count, min_chunk_, fn);
+	}
+
+	template <typename InputIt, typename OutputIt, typename UnaryOp>
+	OutputIt Transform(InputIt first, InputIt last, OutputIt out, UnaryOp op) {
+		const size_t count = last - first;
+		For(count, [&](size_t begin, size_t end) {
+			std::transform(first + begin, first + end, out + begin, op);
+		});
+		return out + count;
+	}
+
+	// Как std::reduce, но части сворачиваются слева направо: op должна быть ассоциативной,
+	// коммутативность не требуется
+	template <typename It, typename T, typename BinaryOp = std::plus<>>
+	T Reduce(It first, It last, T init, BinaryOp op = BinaryOp()) {
+		const size_t count = last - first;
+		if (count == 0) {
+			return init;
+		}
+		return op(std::move(init), ReduceRange<T>(first, count, op));
+	}
+
+	// Сканирование в три прохода: суммы частей, префиксные суммы частей (последовательно),
+	// сканирование частей со смещением. out может совпадать с first.
+	template <typename InputIt, typename OutputIt, typename BinaryOp = std::plus<>>
+	OutputIt InclusiveScan(InputIt first, InputIt last, OutputIt out, BinaryOp op = BinaryOp()) {
+		using T = typename std::iterator_traits<InputIt>::value_type;
+		return Scan<T>(first, last, out, std::optional<T>(), op, false);
+	}
+
+	template <typename InputIt, typename OutputIt, typename T, typename BinaryOp = std::plus<>>
+	OutputIt ExclusiveScan(InputIt first, InputIt last, OutputIt out, T init, BinaryOp op = BinaryOp()) {
+		return Scan<T>(first, last, out, std::optional<T>(std::move(init)), op, true);
+	}
+
+	// Параллельная сортировка слиянием: части сортируются std::sort, слияния идут между
+	// массивом и вспомогательным буфером по очереди, а каждое слияние делится на независимые
+	// части поиском медианы. Порядок равных элементов не сохраняется.
+	template <typename T, typename Compare = std::less<>>
+	void Sort(T* first, T* last, Compare comp = Compare()) {
+		const size_t count = last - first;
+		if (count <= min_chunk_ || pool_.Concurrency() == 1) {
+			std::sort(first, last, comp);
+			return;
+		}
+		const ScratchFrame scratch(*this, count * sizeof(T), alignof(T));
+		T* buffer = static_cast<T*>(scratch.Data());
+		if constexpr (std::is_trivially_copyable_v<T>) {
+			SortInto(first, buffer, count, false, comp);
+		}
+		else {
+			// Слияния присваивают элементы, поэтому в буфере должны быть объекты: элементы
+			// переезжают в буфер, а результат собирается в исходном массиве
+			std::uninitialized_move_n(first, count, buffer);
+			try {
+				SortInto(buffer, first, count, true, comp);
+			}
+			catch (...) {
+				detail::DestroyN(buffer, count);
+				throw;
+			}
+			detail::DestroyN(buffer, count);
+		}
+	}
+
+	// Устойчивое разбиение за четыре прохода: предикат (один раз для каждого элемента),
+	// префиксные суммы частей, перенос элементов в буфер на итоговые места и обратно.
+	// Элементы, перемещение которых может бросить исключение, разбиваются std::stable_partition.
+	template <typename T, typename Predicate>
+	T* StablePartition(T* first, T* last, Predicate pred) {
+		if constexpr (detail::RelocationOf<T>() != Relocation::BITWISE && !std::is_nothrow_move_constructible_v<T>) {
+			return std::stable_partition(first, last, pred);
+		}
+		else {
+			const size_t count = last - first;
+			const size_t chunks = ChunksFor(count);
+			if (chunks == 1) {
+				return std::stable_partition(first, last, pred);
+			}
+			const size_t flags_bytes = (count + alignof(T) - 1) / alignof(T) * alignof(T);
+			const ScratchFrame scratch(*this, flags_bytes + count * sizeof(T), alignof(T));
+			unsigned char* flags = static_cast<unsigned char*>(scratch.Data());
+			T* buffer = reinterpret_cast<T*>(flags + flags_bytes);
+
+			Vector<size_t> true_offsets(chunks + 1);
+			ForRange(0, chunks, 1, [&](size_t begin, size_t end) {
+				for (size_t chunk = begin; chunk < end; ++chunk) {
+					size_t selected = 0;
+					for (size_t i = detail::ChunkBegin(count, chunks, chunk); i < detail::ChunkBegin(count, chunks, chunk + 1); ++i) {
+						flags[i] = pred(first[i]) ? 1 : 0;
+						selected += flags[i];
+					}
+					true_offsets[chunk + 1] = selected;
+				}
+			});
+			for (size_t chunk = 0; chunk < chunks; ++chunk) {
+				true_offsets[chunk + 1] += true_offsets[chunk];
+			}
+			const size_t total_true = true_offsets[chunks];
+
+			// Дальше ничего не бросает исключений: перенос элементов не бросает
+			ForRange(0, chunks, 1, [&](size_t begin, size_t end) noexcept {
+				for (size_t chunk = begin; chunk < end; ++chunk) {
+					const size_t chunk_begin = detail::ChunkBegin(count, chunks, chunk);
+					size_t to_true = true_offsets[chunk];
+					size_t to_false = total_true + (chunk_begin - true_offsets[chunk]);
+					for (size_t i = chunk_begin; i < detail::ChunkBegin(count, chunks, chunk + 1); ++i) {
+						T* to = buffer + (flags[i] ? to_true++ : to_false++);
+						detail::UninitializedRelocate(first + i, 1, to);
+						detail::DestroyRelocated(first + i, 1);
+					}
+				}
+			});
+			ForRange(0, count, min_chunk_, [&](size_t begin, size_t end) noexcept {
+				detail::UninitializedRelocate(buffer + begin, end - begin, first + begin);
+				detail::DestroyRelocated(buffer + begin, end - begin);
+			});
+			return first + total_true;
+		}
+	}
+
+	size_t ScratchBytes() const noexcept {
+		return scratch_.Capacity() * sizeof(std::max_align_t);
+	}
+
+	// Освобождает вспомогательный буфер
+	void ReleaseScratch() noexcept {
+		assert(!scratch_busy_);
+		scratch_ = RawMemory<std::max_align_t>();
+	}
+
+private:
+	// Вспомогательный буфер одного вызова Sort или StablePartition. Буфер исполнителя растёт
+	// до самого большого запроса и не уменьшается. Пока он занят, вложенный вызов на том же
+	// потоке (задача, украденная во время ожидания Invoke) получает собственный буфер.
+	class ScratchFrame {
+	public:
+		ScratchFrame(ParallelExecutor& executor, size_t bytes, size_t align)
+			: executor_(executor) {
+			static_cast<void>(align);
+			assert(align <= alignof(std::max_align_t));
+			const size_t blocks = (bytes + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+			if (executor.scratch_busy_) {
+				own_ = RawMemory<std::max_align_t>(blocks);
+				data_ = own_.GetAddress();
+				return;
+			}
+			if (blocks > executor.scratch_.Capacity()) {
+				executor.scratch_ = RawMemory<std::max_align_t>();
+				executor.scratch_ = RawMemory<std::max_align_t>(blocks);
+			}
+			executor.scratch_busy_ = true;
+			shared_ = true;
+			data_ = executor.scratch_.GetAddress();
+		}
+
+		ScratchFrame(const ScratchFrame&) = delete;
+		ScratchFrame& operator=(const ScratchFrame&) = delete;
+
+		~ScratchFrame() {
+			if (shared_) {
+				executor_.scratch_busy_ = false;
+			}
+		}
+
+		void* Data() const noexcept {
+			return data_;
+		}
+
+	private:
+		ParallelExecutor& executor_;
+		RawMemory<std::max_align_t> own_;
+		void* data_ = nullptr;
+		bool shared_ = false;
+	};
+
+	// Число частей для многопроходных алгоритмов: по нескольку на поток для балансировки
+	size_t ChunksFor(size_t count) const noexcept {
+		const size_t by_size = (count + min_chunk_ - 1) / min_chunk_;
+		return std::max<size_t>(std::min(pool_.Concurrency() * 4, by_size), 1);
+	}
+
+	template <typename Fn>
+	void ForRange(size_t first, size_t last, size_t grain, Fn&& fn) {
+		if (last - first <= grain) {
+			if (first != last) {
+				fn(first, last);
+			}
+			return;
+		}
+		const size_t mid = first + (last - first) / 2;
+		pool_.Invoke([&] {
+			ForRange(first, mid, grain, fn);
+		}, [&] {
+			ForRange(mid, last, grain, fn);
+		});
+	}
+
+	template <typename T, typename It, typename BinaryOp>
+	T ReduceRange(It first, size_t count, BinaryOp& op) {
+		if (count <= min_chunk_) {
+			T result = first[0];
+			for (size_t i = 1; i < count; ++i) {
+				result = op(std::move(result), first[i]);
+			}
+			return result;
+		}
+		const size_t half = count / 2;
+		std::optional<T> left;
+		std::optional<T> right;
+		pool_.Invoke([&] {
+			left.emplace(ReduceRange<T>(first, half, op));
+		}, [&] {
+			right.emplace(ReduceRange<T>(first + half, count - half, op));
+		});
+		return op(std::move(*left), std::move(*right));
+	}
+
+	template <typename T, typename InputIt, typename OutputIt, typename BinaryOp>
+	OutputIt Scan(InputIt first, InputIt last, OutputIt out, std::optional<T> init, BinaryOp& op, bool exclusive) {
+		const size_t count = last - first;
+		const size_t chunks = ChunksFor(count);
+		// Для последней части сумма не нужна
+		Vector<std::optional<T>> offsets(chunks);
+		offsets[0] = std::move(init);
+		if (chunks > 1) {
+			ForRange(0, chunks - 1, 1, [&](size_t begin, size_t end) {
+				for (size_t chunk = begin; chunk < end; ++chunk) {
+					const size_t chunk_begin = detail::ChunkBegin(count, chunks, chunk);
+					offsets[chunk + 1] = ReduceRange<T>(first + chunk_begin,
+						detail::ChunkBegin(count, chunks, chunk + 1) - chunk_begin, op);
+				}
+			});
+			for (size_t chunk = 1; chunk < chunks; ++chunk) {
+				if (offsets[chunk - 1]) {
+					offsets[chunk] = op(*offsets[chunk - 1], std::move(*offsets[chunk]));
+				}
+			}
+		}
+		ForRange(0, chunks, 1, [&](size_t begin, size_t end) {
+			for (size_t chunk = begin; chunk < end; ++chunk) {
+				std::optional<T> acc = offsets[chunk];
+				for (size_t i = detail::ChunkBegin(count, chunks, chunk); i < detail::ChunkBegin(count, chunks, chunk + 1); ++i) {
+					// Элемент читается до записи: out может совпадать с first
+					T value = first[i];
+					if (exclusive) {
+						out[i] = *acc;
+						acc = op(std::move(*acc), std::move(value));
+					}
+					else {
+						acc = acc ? op(std::move(*acc), std::move(value)) : std::move(value);
+						out[i] = *acc;
+					}
+				}
+			}
+		});
+		return out + count;
+	}
+
+	// Сортирует [data, data + count); результат остаётся в data или, если to_buffer, в buffer
+	template <typename T, typename Compare>
+	void SortInto(T* data, T* buffer, size_t count, bool to_buffer, Compare& comp) {
+		if (count <= min_chunk_) {
+			std::sort(data, data + count, comp);
+			if (to_buffer) {
+				std::move(data, data + count, buffer);
+			}
+			return;
+		}
+		const size_t half = count / 2;
+		pool_.Invoke([&] {
+			SortInto(data, buffer, half, !to_buffer, comp);
+		}, [&] {
+			SortInto(data + half, buffer + half, count - half, !to_buffer, comp);
+		});
+		T* from = to_buffer ? data : buffer;
+		T* to = to_buffer ? buffer : data;
+		Merge(from, half, from + half, count - half, to, comp);
+	}
+
+	// Сливает left и right в out. Средний элемент большего массива встаёт на своё место,
+	// меньший массив делится по нему двоичным поиском, и две половины сливаются независимо.
+	// Равные элементы left идут раньше элементов right.
+	template <typename T, typename Compare>
+	void Merge(T* left, size_t left_count, T* right, size_t right_count, T* out, Compare& comp) {
+		if (left_count + right_count <= min_chunk_ || left_count == 0 || right_count == 0) {
+			std::merge(std::make_move_iterator(left), std::make_move_iterator(left + left_count),
+				std::make_move_iterator(right), std::make_move_iterator(right + right_count), out, comp);
+			return;
+		}
+		size_t left_mid = 0;
+		size_t right_mid = 0;
+		// Средний элемент большего массива уже на месте и в хвост не входит
+		size_t left_tail = 0;
+		size_t right_tail = 0;
+		if (left_count >= right_count) {
+			left_mid = left_count / 2;
+			right_mid = std::lower_bound(right, right + right_count, left[left_mid], comp) - right;
+			out[left_mid + right_mid] = std::move(left[left_mid]);
+			left_tail = 1;
+		}
+		else {
+			right_mid = right_count / 2;
+			left_mid = std::upper_bound(left, left + left_count, right[right_mid], comp) - left;
+			out[left_mid + right_mid] = std::move(right[right_mid]);
+			right_tail = 1;
+		}
+		pool_.Invoke([&] {
+			Merge(left, left_mid, right, right_mid, out, comp);
+		}, [&] {
+			Merge(left + left_mid + left_tail, left_count - left_mid - left_tail,
+				right + right_mid + right_tail, right_count - right_mid - right_tail,
+				out + left_mid + right_mid + 1, comp);
+		});
+	}
+
+	WorkStealingPool& pool_;
+	size_t min_chunk_;
+	RawMemory<std::max_align_t> scratch_;
+	bool scratch_busy_ = false;
+};
+
+template <typename T, typename Compare = std::less<>>
+void ParallelSort(T* first, T* last, Compare comp = Compare()) {
+	ParallelExecutor::Local().Sort(first, last, comp);
+}
+
+template <typename InputIt, typename OutputIt, typename UnaryOp>
+OutputIt ParallelTransform(InputIt first, InputIt last, OutputIt out, UnaryOp op) {
+	return ParallelExecutor::Local().Transform(first, last, out, op);
+}
+
+template <typename It, typename T, typename BinaryOp = std::plus<>>
+T ParallelReduce(It first, It last, T init, BinaryOp op = BinaryOp()) {
+	return ParallelExecutor::Local().Reduce(first, last, std::move(init), op);
+}
+
+template <typename InputIt, typename OutputIt, typename BinaryOp = std::plus<>>
+OutputIt ParallelInclusiveScan(InputIt first, InputIt last, OutputIt out, BinaryOp op = BinaryOp()) {
+	return ParallelExecutor::Local().InclusiveScan(first, last, out, op);
+}
+
+template <typename InputIt, typename OutputIt, typename T, typename BinaryOp = std::plus<>>
+OutputIt ParallelExclusiveScan(InputIt first, InputIt last, OutputIt out, T init, BinaryOp op = BinaryOp()) {
+	return ParallelExecutor::Local().ExclusiveScan(first, last, out, std::move(init), op);
+}
+
+template <typename T, typename Predicate>
+T* ParallelStablePartition(T* first, T* last, Predicate pred) {
+	return ParallelExecutor::Local().StablePartition(first, last, pred);
+}
@@ -0,0 +1,209 @@
+#pragma once
+#include "vector.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+
+// Размещение больших буферов (Linux): выравнивание по огромным страницам и политика NUMA.
+// Политика задаётся подсказкой ядру: если ядро или машина её не поддерживают,
+// память выделяется как обычно.
+enum class NumaPolicy {
+	DEFAULT,     // политика потока, обычно узел потока, первым обратившегося к странице
+	LOCAL,       // узел потока, первым обратившегося к странице, независимо от политики потока
+	BIND,        // только узлы из маски nodes
+	INTERLEAVE,  // страницы по очереди с узлов из маски nodes
+};
+
+struct Placement {
+	// Блоки от этого размера выделяются через mmap, выравниваются и округляются до огромных
+	// страниц и получают MADV_HUGEPAGE и политику NUMA. Меньшие блоки берутся из operator new.
+	size_t huge_page_threshold = HUGE_PAGE_BYTES;
+	NumaPolicy numa = NumaPolicy::DEFAULT;
+	std::uint64_t nodes = 0;  // маска узлов для BIND и INTERLEAVE; 0 — все узлы
+
+	// Маска узлов 64-битная: для node >= 64 выбрасывает std::invalid_argument
+	static constexpr Placement OnNode(unsigned node) {
+		if (node >= 64) {
+			throw std::invalid_argument("NUMA node does not fit the 64-bit node mask");
+		}
+		return { HUGE_PAGE_BYTES, NumaPolicy::BIND, std::uint64_t{ 1 } << node };
+	}
+
+	static constexpr Placement Interleaved(std::uint64_t nodes = 0) noexcept {
+		return { HUGE_PAGE_BYTES, NumaPolicy::INTERLEAVE, nodes };
+	}
+};
+
+// Размещение по умолчанию для буферов элементов типа T. Специализируйте шаблон,
+// чтобы выбрать размещение для всех векторов своего типа.
+template <typename T>
+struct DefaultPlacement {
+	static constexpr Placement VALUE{};
+};
+
+// Аллокатор с выбираемым размещением. Размещение задаётся для экземпляра (через конструктор)
+// или для типа (через DefaultPlacement<T>). Чтобы страницы буфера оказались на узлах потоков,
+// которые будут его читать, создавайте вектор конструктором Vector(PARALLEL, n, alloc) или
+// заполняйте через Resize(PARALLEL, n): каждый поток первым обращается к своей части буфера,
+// и части распределяются между потоками так же, как в остальных параллельных операциях.
+template <typename T>
+class PlacementAllocator {
+	static_assert(alignof(T) <= alignof(std::max_align_t));
+
+public:
+	using value_type = T;
+
+	struct AllocationResult {
+		T* ptr;
+		size_t count;
+	};
+
+	PlacementAllocator() noexcept
+		: placement_(DefaultPlacement<T>::VALUE) {
+	}
+
+	PlacementAllocator(const Placement& placement) noexcept
+		: placement_(placement) {
+	}
+
+	template <typename U>
+	PlacementAllocator(const PlacementAllocator<U>& other) noexcept
+		: placement_(other.GetPlacement()) {
+	}
+
+	// Отображённый блок занимает целое число огромных страниц: остаток отдаётся вектору
+	AllocationResult allocate_at_least(size_t n) {
+		const size_t bytes = ByteSize(n);
+		if (!IsMapped(bytes)) {
+			return { allocate(n), n };
+		}
+		const size_t count = MappedBytes(bytes) / sizeof(T);
+		return { allocate(count), count };
+	}
+
+	T* allocate(size_t n) {
+		const size_t bytes = ByteSize(n);
+		if (!IsMapped(bytes)) {
+			return static_cast<T*>(::operator new(bytes));
+		}
+		return static_cast<T*>(Map(MappedBytes(bytes)));
+	}
+
+	void deallocate(T* p, size_t n) noexcept {
+		const size_t bytes = n * sizeof(T);
+		if (!IsMapped(bytes)) {
+			::operator delete(static_cast<void*>(p), bytes);
+		}
+		else {
+			::munmap(p, MappedBytes(bytes));
+		}
+	}
+
+	const Placement& GetPlacement() const noexcept {
+		return placement_;
+	}
+
+	// Способ освобождения зависит только от порога: политика NUMA на него не влияет
+	template <typename U>
+	bool operator==(const PlacementAllocator<U>& other) const noexcept {
+		return placement_.huge_page_threshold == other.GetPlacement().huge_page_threshold;
+	}
+	template <typename U>
+	bool operator!=(const PlacementAllocator<U>& other) const noexcept {
+		return !(*this == other);
+	}
+
+private:
+	static size_t ByteSize(size_t n) {
+		if (n > (std::numeric_limits<size_t>::max() - HUGE_PAGE_BYTES * 2) / sizeof(T)) {
+			throw std::bad_alloc();
+		}
+		return n * sizeof(T);
+	}
+
+	static size_t MappedBytes(size_t bytes) noexcept {
+		return (bytes + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+	}
+
+	bool IsMapped(size_t bytes) const noexcept {
+		return bytes != 0 && bytes >= placement_.huge_page_threshold;
+	}
+
+	// Отображает на огромную страницу больше и отрезает края, чтобы выровнять начало блока
+	void* Map(size_t length) const {
+		void* address = ::mmap(nullptr, length + HUGE_PAGE_BYTES, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (address == MAP_FAILED) {
+			throw std::bad_alloc();
+		}
+		unsigned char* raw = static_cast<unsigned char*>(address);
+		const std::uintptr_t offset = reinterpret_cast<std::uintptr_t>(raw) % HUGE_PAGE_BYTES;
+		unsigned char* block = offset == 0 ? raw : raw + (HUGE_PAGE_BYTES - offset);
+		if (block != raw) {
+			::munmap(raw, block - raw);
+		}
+		const size_t tail = raw + length + HUGE_PAGE_BYTES - (block + length);
+		if (tail != 0) {
+			::munmap(block + length, tail);
+		}
+#ifdef MADV_HUGEPAGE
+		::madvise(block, length, MADV_HUGEPAGE);
+#endif
+		ApplyNumaPolicy(block, length);
+		return block;
+	}
+
+	// mbind вызывается напрямую, чтобы не зависеть от libnuma. Ошибка означает, что политика
+	// не поддерживается, и не мешает пользоваться памятью.
+	void ApplyNumaPolicy(void* block, size_t length) const noexcept {
+#ifdef SYS_mbind
+		constexpr int MPOL_BIND_MODE = 2;
+		constexpr int MPOL_INTERLEAVE_MODE = 3;
+		constexpr int MPOL_LOCAL_MODE = 4;
+		int mode = 0;
+		switch (placement_.numa) {
+		case NumaPolicy::DEFAULT:
+			return;
+		case NumaPolicy::LOCAL:
+			mode = MPOL_LOCAL_MODE;
+			break;
+		case NumaPolicy::BIND:
+			mode = MPOL_BIND_MODE;
+			break;
+		case NumaPolicy::INTERLEAVE:
+			mode = MPOL_INTERLEAVE_MODE;
+			break;
+		}
+		// Ядро читает max_node - 1 бит маски
+		constexpr unsigned long MAX_NODE = sizeof(unsigned long) * 8 + 1;
+		unsigned long mask = static_cast<unsigned long>(placement_.nodes);
+		if (mode != MPOL_LOCAL_MODE && mask == 0) {
+			// Все узлы, доступные потоку
+			constexpr unsigned long MPOL_F_MEMS_ALLOWED_FLAG = 4;
+			if (::syscall(SYS_get_mempolicy, nullptr, &mask, MAX_NODE, nullptr, MPOL_F_MEMS_ALLOWED_FLAG) != 0) {
+				return;
+			}
+		}
+		if (mode == MPOL_LOCAL_MODE) {
+			::syscall(SYS_mbind, block, length, mode, nullptr, 0ul, 0u);
+		}
+		else {
+			::syscall(SYS_mbind, block, length, mode, &mask, MAX_NODE, 0u);
+		}
+#else
+		static_cast<void>(block);
+		static_cast<void>(length);
+#endif
+	}
+
+	Placement placement_;
+};
+
+// Вектор, большие буферы которого лежат на огромных страницах
+template <typename T, typename Growth = HugePageGrowth>
+using HugePageVector = Vector<T, PlacementAllocator<T>, Growth>;
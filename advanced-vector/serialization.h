@@ -0,0 +1,100 @@
+#pragma once
+#include "vector.h"
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <system_error>
+
+// Двоичный формат: заголовок с количеством элементов и размером элемента, затем байты
+// элементов в порядке байтов текущей платформы. Подходит только для тривиально копируемых типов.
+namespace detail {
+
+struct SerializedHeader {
+	std::uint64_t count;
+	std::uint64_t element_size;
+};
+
+inline void WriteAll(int fd, iovec* iov, int iov_count) {
+	while (iov_count > 0) {
+		const ssize_t written = ::writev(fd, iov, iov_count);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw std::system_error(errno, std::generic_category(), "writev");
+		}
+		// Запись могла оборваться посередине: пропускаем записанные части
+		size_t rest = static_cast<size_t>(written);
+		while (iov_count > 0 && rest >= iov->iov_len) {
+			rest -= iov->iov_len;
+			++iov;
+			--iov_count;
+		}
+		if (iov_count > 0) {
+			iov->iov_base = static_cast<char*>(iov->iov_base) + rest;
+			iov->iov_len -= rest;
+		}
+	}
+}
+
+inline void ReadAll(int fd, void* buffer, size_t bytes) {
+	char* out = static_cast<char*>(buffer);
+	while (bytes > 0) {
+		const ssize_t received = ::read(fd, out, bytes);
+		if (received < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw std::system_error(errno, std::generic_category(), "read");
+		}
+		if (received == 0) {
+			throw std::runtime_error("Serialized vector is truncated");
+		}
+		out += received;
+		bytes -= static_cast<size_t>(received);
+	}
+}
+
+}  // namespace detail
+
+// Записывает элементы контейнера (Vector, SmallVector, VectorView и т.п.) одним вызовом writev
+template <typename Container>
+void Serialize(int fd, const Container& container) {
+	using T = std::remove_const_t<std::remove_pointer_t<decltype(container.begin())>>;
+	static_assert(std::is_trivially_copyable_v<T>, "Serialize requires a trivially copyable T");
+
+	const VectorView<const T> view(container.begin(), container.Size());
+	detail::SerializedHeader header{ view.Size(), sizeof(T) };
+	iovec iov[2] = {
+		{ &header, sizeof(header) },
+		{ const_cast<T*>(view.Data()), view.SizeBytes() },
+	};
+	detail::WriteAll(fd, iov, view.Empty() ? 1 : 2);
+}
+
+// Читает вектор, записанный Serialize. Байты читаются прямо в буфер нового вектора,
+// элементы не инициализируются перед чтением.
+template <typename T, typename Alloc = std::allocator<T>, typename Growth = DoublingGrowth,
+	typename Stats = NoVectorStats>
+Vector<T, Alloc, Growth, Stats> Deserialize(int fd, const Alloc& alloc = Alloc()) {
+	static_assert(std::is_trivially_copyable_v<T>, "Deserialize requires a trivially copyable T");
+
+	detail::SerializedHeader header{};
+	detail::ReadAll(fd, &header, sizeof(header));
+	if (header.element_size != sizeof(T)) {
+		throw std::runtime_error("Serialized vector holds elements of a different size");
+	}
+	if (header.count > std::numeric_limits<size_t>::max() / sizeof(T)) {
+		throw std::runtime_error("Serialized vector is too large");
+	}
+	Vector<T, Alloc, Growth, Stats> v(alloc);
+	v.ResizeForOverwrite(static_cast<size_t>(header.count), [fd](T* data, size_t count) {
+		detail::ReadAll(fd, data, count * sizeof(T));
+		return count;
+	});
+	return v;
+}
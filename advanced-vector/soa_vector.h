@@ -0,0 +1,449 @@
+#pragma once
+#include "vector.h"
+
+#include <cassert>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Вектор записей, хранящий каждое поле в отдельном столбце (structure of arrays).
+// Все столбцы имеют общие размер и вместимость и реаллоцируются вместе. Циклы по одному
+// полю читают только его столбец через Column<I>(), строки доступны через прокси-ссылки.
+template <typename... Fields>
+class SoAVector {
+	static_assert(sizeof...(Fields) > 0);
+
+	using Columns = std::tuple<RawMemory<Fields>...>;
+
+public:
+	static constexpr size_t COLUMNS = sizeof...(Fields);
+	static constexpr size_t ROW_BYTES = (sizeof(Fields) + ...);
+
+	template <size_t I>
+	using FieldType = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+	// Прокси-ссылка на строку: поля доступны через Get<I>()
+	template <bool Const>
+	class RowReference {
+		using Owner = std::conditional_t<Const, const SoAVector, SoAVector>;
+
+	public:
+		RowReference(Owner& owner, size_t index) noexcept
+			: owner_(&owner)
+			, index_(index) {
+		}
+
+		RowReference(const RowReference& other) = default;
+
+		template <size_t I>
+		auto& Get() const noexcept {
+			return owner_->template Column<I>()[index_];
+		}
+
+		auto Tie() const noexcept {
+			return TieImpl(std::index_sequence_for<Fields...>());
+		}
+
+		// Копия значений строки
+		operator std::tuple<Fields...>() const {
+			return Tie();
+		}
+
+		template <bool C = Const, typename = std::enable_if_t<!C>>
+		const RowReference& operator=(const std::tuple<Fields...>& values) const {
+			Tie() = values;
+			return *this;
+		}
+
+		// Присваивание строке копирует значения полей, а не перепривязывает ссылку
+		const RowReference& operator=(const RowReference& other) const {
+			static_assert(!Const, "rows are read-only through ConstReference");
+			Tie() = other.Tie();
+			return *this;
+		}
+
+		template <bool C = Const, typename = std::enable_if_t<!C>>
+		const RowReference& operator=(const RowReference<true>& other) const {
+			Tie() = other.Tie();
+			return *this;
+		}
+
+	private:
+		template <size_t... I>
+		auto TieImpl(std::index_sequence<I...>) const noexcept {
+			return std::tie(Get<I>()...);
+		}
+
+		Owner* owner_;
+		size_t index_;
+	};
+
+	using Reference = RowReference<false>;
+	using ConstReference = RowReference<true>;
+
+	template <bool Const>
+	class RowIterator {
+		using Owner = std::conditional_t<Const, const SoAVector, SoAVector>;
+
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = std::tuple<Fields...>;
+		using difference_type = std::ptrdiff_t;
+		using reference = RowReference<Const>;
+		using pointer = void;
+
+		RowIterator() = default;
+
+		RowIterator(Owner& owner, size_t index) noexcept
+			: owner_(&owner)
+			, index_(index) {
+		}
+
+		reference operator*() const noexcept {
+			return reference(*owner_, index_);
+		}
+		reference operator[](difference_type n) const noexcept {
+			return reference(*owner_, index_ + n);
+		}
+		RowIterator& operator++() noexcept {
+			++index_;
+			return *this;
+		}
+		RowIterator operator++(int) noexcept {
+			RowIterator old = *this;
+			++index_;
+			return old;
+		}
+		RowIterator& operator--() noexcept {
+			--index_;
+			return *this;
+		}
+		RowIterator operator--(int) noexcept {
+			RowIterator old = *this;
+			--index_;
+			return old;
+		}
+		RowIterator& operator+=(difference_type n) noexcept {
+			index_ += n;
+			return *this;
+		}
+		RowIterator& operator-=(difference_type n) noexcept {
+			index_ -= n;
+			return *this;
+		}
+		RowIterator operator+(difference_type n) const noexcept {
+			return RowIterator(*owner_, index_ + n);
+		}
+		RowIterator operator-(difference_type n) const noexcept {
+			return RowIterator(*owner_, index_ - n);
+		}
+		friend RowIterator operator+(difference_type n, const RowIterator& it) noexcept {
+			return it + n;
+		}
+
+		// Сравнения и разность принимают и iterator, и const_iterator
+		template <bool C>
+		difference_type operator-(const RowIterator<C>& other) const noexcept {
+			return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_);
+		}
+		template <bool C>
+		bool operator==(const RowIterator<C>& other) const noexcept {
+			return index_ == other.index_;
+		}
+		template <bool C>
+		bool operator!=(const RowIterator<C>& other) const noexcept {
+			return index_ != other.index_;
+		}
+		template <bool C>
+		bool operator<(const RowIterator<C>& other) const noexcept {
+			return index_ < other.index_;
+		}
+		template <bool C>
+		bool operator>(const RowIterator<C>& other) const noexcept {
+			return index_ > other.index_;
+		}
+		template <bool C>
+		bool operator<=(const RowIterator<C>& other) const noexcept {
+			return index_ <= other.index_;
+		}
+		template <bool C>
+		bool operator>=(const RowIterator<C>& other) const noexcept {
+			return index_ >= other.index_;
+		}
+
+	private:
+		template <bool C>
+		friend class RowIterator;
+
+		Owner* owner_ = nullptr;
+		size_t index_ = 0;
+	};
+
+	using iterator = RowIterator<false>;
+	using const_iterator = RowIterator<true>;
+
+	SoAVector() = default;
+
+	explicit SoAVector(size_t size) {
+		Resize(size);
+	}
+
+	SoAVector(const SoAVector& other) {
+		Columns columns = AllocateColumns(other.size_);
+		auto copy = [&](auto i) {
+			std::uninitialized_copy_n(std::get<i>(other.columns_).GetAddress(), other.size_,
+				std::get<i>(columns).GetAddress());
+		};
+		auto destroy = [&](auto i) {
+			detail::DestroyN(std::get<i>(columns).GetAddress(), other.size_);
+		};
+		Transact<0>(copy, destroy);
+		columns_.swap(columns);
+		size_ = other.size_;
+		capacity_ = other.size_;
+	}
+
+	SoAVector(SoAVector&& other) noexcept
+		: columns_(std::move(other.columns_))
+		, size_(std::exchange(other.size_, 0))
+		, capacity_(std::exchange(other.capacity_, 0)) {
+	}
+
+	SoAVector& operator=(const SoAVector& rhs) {
+		if (this != &rhs) {
+			SoAVector copy(rhs);
+			Swap(copy);
+		}
+		return *this;
+	}
+
+	SoAVector& operator=(SoAVector&& rhs) noexcept {
+		if (this != &rhs) {
+			Clear();
+			SoAVector empty;
+			Swap(empty);
+			Swap(rhs);
+		}
+		return *this;
+	}
+
+	~SoAVector() {
+		Clear();
+	}
+
+	iterator begin() noexcept {
+		return iterator(*this, 0);
+	}
+	iterator end() noexcept {
+		return iterator(*this, size_);
+	}
+	const_iterator begin() const noexcept {
+		return const_iterator(*this, 0);
+	}
+	const_iterator end() const noexcept {
+		return const_iterator(*this, size_);
+	}
+	const_iterator cbegin() const noexcept {
+		return begin();
+	}
+	const_iterator cend() const noexcept {
+		return end();
+	}
+
+	size_t Size() const noexcept {
+		return size_;
+	}
+
+	size_t Capacity() const noexcept {
+		return capacity_;
+	}
+
+	Reference operator[](size_t index) noexcept {
+		assert(index < size_);
+		return Reference(*this, index);
+	}
+
+	ConstReference operator[](size_t index) const noexcept {
+		assert(index < size_);
+		return ConstReference(*this, index);
+	}
+
+	// Непрерывный столбец поля I
+	template <size_t I>
+	VectorView<FieldType<I>> Column() noexcept {
+		return VectorView<FieldType<I>>(std::get<I>(columns_).GetAddress(), size_);
+	}
+
+	template <size_t I>
+	VectorView<const FieldType<I>> Column() const noexcept {
+		return VectorView<const FieldType<I>>(std::get<I>(columns_).GetAddress(), size_);
+	}
+
+	void Reserve(size_t capacity) {
+		if (capacity > capacity_) {
+			Columns columns = AllocateColumns(capacity);
+			RelocateColumns(columns);
+			AdoptColumns(columns, capacity);
+		}
+	}
+
+	// Строгая гарантия: при исключении в одном из столбцов созданные поля разрушаются
+	void Resize(size_t new_size) {
+		if (new_size < size_) {
+			ForEachColumn([&](auto i) {
+				detail::DestroyN(std::get<i>(columns_).GetAddress() + new_size, size_ - new_size);
+			});
+		}
+		else if (new_size > size_) {
+			Reserve(new_size);
+			auto construct = [&](auto i) {
+				std::uninitialized_value_construct_n(std::get<i>(columns_).GetAddress() + size_, new_size - size_);
+			};
+			auto destroy = [&](auto i) {
+				detail::DestroyN(std::get<i>(columns_).GetAddress() + size_, new_size - size_);
+			};
+			Transact<0>(construct, destroy);
+		}
+		size_ = new_size;
+	}
+
+	// Принимает по одному аргументу на поле. Предоставляет строгую гарантию безопасности
+	// исключений на тех же условиях, что и Vector::EmplaceBack.
+	template <typename... Args>
+	Reference EmplaceBack(Args&&... args) {
+		static_assert(sizeof...(Args) == COLUMNS, "EmplaceBack takes one argument per field");
+		auto values = std::forward_as_tuple(std::forward<Args>(args)...);
+		if (size_ == capacity_) {
+			const size_t capacity = DoublingGrowth::NextCapacity(capacity_, ROW_BYTES);
+			Columns columns = AllocateColumns(capacity);
+			// Новая строка создаётся до переноса: аргументы могут ссылаться на элементы вектора
+			ConstructRow(columns, values);
+			try {
+				RelocateColumns(columns);
+			}
+			catch (...) {
+				DestroyRow(columns);
+				throw;
+			}
+			AdoptColumns(columns, capacity);
+		}
+		else {
+			ConstructRow(columns_, values);
+		}
+		++size_;
+		return Reference(*this, size_ - 1);
+	}
+
+	void PushBack(const std::tuple<Fields...>& row) {
+		std::apply([this](const Fields&... fields) { EmplaceBack(fields...); }, row);
+	}
+
+	void PopBack() noexcept {
+		assert(size_ != 0);
+		--size_;
+		DestroyRow(columns_);
+	}
+
+	void Clear() noexcept {
+		ForEachColumn([this](auto i) {
+			detail::DestroyN(std::get<i>(columns_).GetAddress(), size_);
+		});
+		size_ = 0;
+	}
+
+	void Swap(SoAVector& other) noexcept {
+		columns_.swap(other.columns_);
+		std::swap(size_, other.size_);
+		std::swap(capacity_, other.capacity_);
+	}
+
+private:
+	template <typename Fn>
+	static void ForEachColumn(Fn&& fn) {
+		ForEachColumnImpl(fn, std::index_sequence_for<Fields...>());
+	}
+
+	template <typename Fn, size_t... I>
+	static void ForEachColumnImpl(Fn& fn, std::index_sequence<I...>) {
+		(fn(std::integral_constant<size_t, I>()), ...);
+	}
+
+	// Выполняет step для столбцов I, I + 1, ...; если шаг столбца выбросил исключение,
+	// для уже выполненных шагов в обратном порядке вызывается undo
+	template <size_t I, typename Step, typename Undo>
+	static void Transact(Step& step, Undo& undo) {
+		if constexpr (I < COLUMNS) {
+			step(std::integral_constant<size_t, I>());
+			try {
+				Transact<I + 1>(step, undo);
+			}
+			catch (...) {
+				undo(std::integral_constant<size_t, I>());
+				throw;
+			}
+		}
+	}
+
+	static Columns AllocateColumns(size_t capacity) {
+		return Columns(RawMemory<Fields>(capacity)...);
+	}
+
+	template <typename Values>
+	void ConstructRow(Columns& columns, Values& values) {
+		auto construct = [&](auto i) {
+			new(std::get<i>(columns) + size_) FieldType<i>(std::get<i>(std::move(values)));
+		};
+		auto destroy = [&](auto i) {
+			std::destroy_at(std::get<i>(columns) + size_);
+		};
+		Transact<0>(construct, destroy);
+	}
+
+	void DestroyRow(Columns& columns) noexcept {
+		ForEachColumn([&](auto i) {
+			std::destroy_at(std::get<i>(columns) + size_);
+		});
+	}
+
+	// Сначала переносятся столбцы, перенос которых копированием может выбросить исключение,
+	// пока исходные элементы остальных столбцов нетронуты
+	void RelocateColumns(Columns& columns) {
+		auto relocate = [&](auto i, auto copying) {
+			using Field = FieldType<i>;
+			if constexpr ((detail::RelocationOf<Field>() == Relocation::COPY) == copying) {
+				detail::UninitializedRelocate(std::get<i>(columns_).GetAddress(), size_, std::get<i>(columns).GetAddress());
+			}
+		};
+		auto undo = [&](auto i, auto copying) {
+			using Field = FieldType<i>;
+			if constexpr ((detail::RelocationOf<Field>() == Relocation::COPY) == copying) {
+				detail::DestroyN(std::get<i>(columns).GetAddress(), size_);
+			}
+		};
+		auto relocate_copied = [&](auto i) { relocate(i, std::true_type()); };
+		auto undo_copied = [&](auto i) { undo(i, std::true_type()); };
+		auto relocate_moved = [&](auto i) { relocate(i, std::false_type()); };
+		auto undo_moved = [&](auto i) { undo(i, std::false_type()); };
+		Transact<0>(relocate_copied, undo_copied);
+		try {
+			Transact<0>(relocate_moved, undo_moved);
+		}
+		catch (...) {
+			ForEachColumn(undo_copied);
+			throw;
+		}
+	}
+
+	void AdoptColumns(Columns& columns, size_t capacity) noexcept {
+		ForEachColumn([&](auto i) {
+			detail::DestroyRelocated(std::get<i>(columns_).GetAddress(), size_);
+			std::get<i>(columns_).Swap(std::get<i>(columns));
+		});
+		capacity_ = capacity;
+	}
+
+	Columns columns_;
+	size_t size_ = 0;
+	size_t capacity_ = 0;
+};
@@ -0,0 +1,526 @@
+// Дифференциальная проверка Vector: длинные случайные последовательности операций выполняются
+// над Vector и над эталонным std::vector и сравниваются после каждого шага. Элементы по команде
+// выбрасывают исключения при создании и копировании, поэтому проверяются и гарантии безопасности
+// исключений на путях с побитовым переносом, realloc, ростом на месте и параллельным заполнением.
+// Сборка: g++ -std=c++17 -O1 -g -fsanitize=address,undefined -pthread stress.cpp -o stress
+// Запуск: ./stress [число операций на конфигурацию] [seed]
+// Для каждой операции печатаются число вызовов и исключений, выделения памяти и время вызова.
+
+#include "vector.h"
+#include "arena_vector.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    // Текущий шаг для сообщения об ошибке
+    struct Context {
+        const char* config = "";
+        const char* operation = "";
+        size_t step = 0;
+        std::uint64_t seed = 0;
+    };
+
+    Context context;
+
+    [[noreturn]] void Fail(const std::string& message) {
+        std::cerr << "FAILED: " << message << " (config " << context.config << ", operation "
+            << context.operation << ", step " << context.step << ", seed " << context.seed << ")" << std::endl;
+        std::abort();
+    }
+
+    void Require(bool condition, const char* message) {
+        if (!condition) {
+            Fail(message);
+        }
+    }
+
+    struct InjectedFault : std::runtime_error {
+        InjectedFault()
+            : std::runtime_error("injected fault") {
+        }
+    };
+
+    // Число операций элементов до исключения, 0 — исключений нет. Счётчики атомарные:
+    // параллельные операции создают элементы в нескольких потоках.
+    std::atomic<long> fault_countdown{ 0 };
+    std::atomic<long> alive_elements{ 0 };
+
+    void MaybeThrow() {
+        if (fault_countdown.load(std::memory_order_relaxed) > 0
+            && fault_countdown.fetch_sub(1, std::memory_order_relaxed) == 1) {
+            throw InjectedFault();
+        }
+    }
+
+    inline const uint32_t LIVE_COOKIE = 0xdeadbeef;
+
+    // Элемент с проверкой живости. При NothrowMove = false перемещение может выбросить исключение,
+    // и вектор переносит элементы копированием; Relocatable разрешает побитовый перенос.
+    template <bool NothrowMove, bool Relocatable>
+    struct Element {
+        Element() {
+            MaybeThrow();
+            ++alive_elements;
+        }
+        explicit Element(int id)
+            : id(id) {
+            MaybeThrow();
+            ++alive_elements;
+        }
+        Element(const Element& other)
+            : id(other.Id()) {
+            MaybeThrow();
+            ++alive_elements;
+        }
+        Element(Element&& other) noexcept(NothrowMove)
+            : id(other.Id()) {
+            if constexpr (!NothrowMove) {
+                MaybeThrow();
+            }
+            ++alive_elements;
+        }
+        Element& operator=(const Element& other) {
+            MaybeThrow();
+            id = other.Id();
+            return *this;
+        }
+        Element& operator=(Element&& other) noexcept(NothrowMove) {
+            if constexpr (!NothrowMove) {
+                MaybeThrow();
+            }
+            id = other.Id();
+            return *this;
+        }
+        ~Element() {
+            Require(cookie == LIVE_COOKIE, "element destroyed twice");
+            cookie = 0;
+            --alive_elements;
+        }
+
+        int Id() const {
+            Require(cookie == LIVE_COOKIE, "use of a destroyed element");
+            return id;
+        }
+
+        int id = 0;
+        uint32_t cookie = LIVE_COOKIE;
+    };
+
+    using MovableElement = Element<true, false>;
+    using CopiedElement = Element<false, false>;
+    using RelocatableElement = Element<true, true>;
+
+    int IdOf(int value) {
+        return value;
+    }
+
+    template <bool NothrowMove, bool Relocatable>
+    int IdOf(const Element<NothrowMove, Relocatable>& element) {
+        return element.Id();
+    }
+
+    template <typename T>
+    inline constexpr bool IS_TRACKED = !std::is_same_v<T, int>;
+
+}  // namespace
+
+template <>
+struct IsTriviallyRelocatable<RelocatableElement> : std::true_type {
+};
+
+namespace {
+
+    enum class Operation {
+        EMPLACE_BACK,
+        PUSH_BACK_ELEMENT,
+        EMPLACE,
+        INSERT_ELEMENT,
+        ERASE,
+        ERASE_RANGE,
+        POP_BACK,
+        RESIZE,
+        RESIZE_VALUE,
+        RESIZE_PARALLEL,
+        RESERVE,
+        SHRINK_TO_FIT,
+        COPY_ASSIGN,
+        COPY_PARALLEL,
+        MOVE_ASSIGN,
+        COPY_CONSTRUCT_PARALLEL,
+        SWAP,
+        COUNT,
+    };
+
+    constexpr size_t OPERATION_COUNT = static_cast<size_t>(Operation::COUNT);
+
+    constexpr const char* OPERATION_NAMES[OPERATION_COUNT] = {
+        "EmplaceBack", "PushBack(v[i])", "Emplace", "Insert(v[i])", "Erase", "Erase(range)",
+        "PopBack", "Resize", "Resize(value)", "Resize(PARALLEL)", "Reserve", "ShrinkToFit",
+        "operator=(const&)", "CopyFrom(PARALLEL)", "operator=(&&)", "Vector(PARALLEL, v)", "Swap",
+    };
+
+    // Вставки чаще удалений, чтобы векторы успевали расти и реаллоцироваться
+    constexpr unsigned OPERATION_WEIGHTS[OPERATION_COUNT] = {
+        8, 3, 4, 2, 3, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1,
+    };
+
+    // Маленькие части, чтобы параллельные операции действительно делились между потоками
+    constexpr ParallelTag STRESS_PARALLEL{ 4, 8 };
+
+    constexpr size_t SLOTS = 4;
+    constexpr size_t MAX_SIZE = 300;
+
+    struct OperationStats {
+        size_t calls = 0;
+        size_t faults = 0;
+        size_t allocations = 0;
+        size_t reallocations = 0;
+        size_t expansions = 0;
+        std::chrono::nanoseconds time{ 0 };
+    };
+
+    template <typename T, typename Alloc = std::allocator<T>, typename Growth = DoublingGrowth>
+    class Harness {
+        using Vec = Vector<T, Alloc, Growth, VectorStats>;
+        using Model = std::vector<int>;
+
+    public:
+        Harness(const char* name, std::mt19937_64& random, const Alloc& alloc = Alloc())
+            : name_(name)
+            , random_(random) {
+            for (size_t i = 0; i < SLOTS; ++i) {
+                slots_.emplace_back(alloc);
+                models_.emplace_back();
+            }
+        }
+
+        void Run(size_t steps) {
+            context.config = name_;
+            std::discrete_distribution<size_t> pick_operation(std::begin(OPERATION_WEIGHTS), std::end(OPERATION_WEIGHTS));
+            for (size_t step = 0; step < steps; ++step) {
+                context.step = step;
+                Step(static_cast<Operation>(pick_operation(random_)));
+            }
+            for (size_t i = 0; i < SLOTS; ++i) {
+                Verify(i);
+            }
+            Print();
+        }
+
+    private:
+        void Step(Operation operation) {
+            const size_t target = Random(SLOTS);
+            const size_t source = (target + 1 + Random(SLOTS - 1)) % SLOTS;
+            if (models_[target].size() >= MAX_SIZE && Grows(operation)) {
+                operation = Operation::ERASE_RANGE;
+            }
+            context.operation = OPERATION_NAMES[static_cast<size_t>(operation)];
+            OperationStats& stats = stats_[static_cast<size_t>(operation)];
+            const VectorStatsCounters before = TotalCounters();
+            extra_ = VectorStatsCounters();
+
+            // Исключение выбрасывает одна из первых операций элементов
+            const bool armed = IS_TRACKED<T> && Random(6) == 0;
+            fault_countdown.store(armed ? 1 + static_cast<long>(Random(8)) : 0, std::memory_order_relaxed);
+            bool faulted = false;
+            elapsed_ = std::chrono::nanoseconds(0);
+            try {
+                Apply(operation, target, source);
+            }
+            catch (const InjectedFault&) {
+                faulted = true;
+            }
+            stats.time += elapsed_;
+            fault_countdown.store(0, std::memory_order_relaxed);
+
+            const VectorStatsCounters after = TotalCounters();
+            ++stats.calls;
+            stats.faults += faulted;
+            stats.allocations += after.allocations - before.allocations + extra_.allocations;
+            stats.reallocations += after.reallocations - before.reallocations + extra_.reallocations;
+            stats.expansions += after.expansions - before.expansions + extra_.expansions;
+
+            if (faulted && !IsStrong(operation)) {
+                // Базовая гарантия: вектор остаётся корректным, но его содержимое не определено
+                Resync(target);
+            }
+            Verify(target);
+            Verify(source);
+            if constexpr (IS_TRACKED<T>) {
+                size_t total = 0;
+                for (const Vec& v : slots_) {
+                    total += v.Size();
+                }
+                Require(alive_elements.load() == static_cast<long>(total), "elements leaked or destroyed twice");
+            }
+        }
+
+        void Apply(Operation operation, size_t target, size_t source) {
+            Vec& v = slots_[target];
+            Model& m = models_[target];
+            switch (operation) {
+            case Operation::EMPLACE_BACK: {
+                const int id = NextId();
+                Timed([&] { v.EmplaceBack(id); });
+                m.push_back(id);
+                break;
+            }
+            case Operation::PUSH_BACK_ELEMENT: {
+                // Аргумент — элемент самого вектора: при реаллокации ссылка не должна испортиться
+                if (m.empty()) {
+                    return Apply(Operation::EMPLACE_BACK, target, source);
+                }
+                const size_t index = Random(m.size());
+                Timed([&] { v.PushBack(v[index]); });
+                m.push_back(m[index]);
+                break;
+            }
+            case Operation::EMPLACE: {
+                const size_t pos = Random(m.size() + 1);
+                const int id = NextId();
+                Timed([&] { v.Emplace(v.cbegin() + pos, id); });
+                m.insert(m.begin() + pos, id);
+                break;
+            }
+            case Operation::INSERT_ELEMENT: {
+                if (m.empty()) {
+                    return Apply(Operation::EMPLACE, target, source);
+                }
+                const size_t pos = Random(m.size() + 1);
+                const size_t index = Random(m.size());
+                const int id = m[index];
+                Timed([&] { v.Insert(v.cbegin() + pos, v[index]); });
+                m.insert(m.begin() + pos, id);
+                break;
+            }
+            case Operation::ERASE: {
+                if (m.empty()) {
+                    return;
+                }
+                const size_t pos = Random(m.size());
+                Timed([&] { v.Erase(v.cbegin() + pos); });
+                m.erase(m.begin() + pos);
+                break;
+            }
+            case Operation::ERASE_RANGE: {
+                const size_t first = Random(m.size() + 1);
+                const size_t last = first + Random(m.size() - first + 1);
+                Timed([&] { v.Erase(v.cbegin() + first, v.cbegin() + last); });
+                m.erase(m.begin() + first, m.begin() + last);
+                break;
+            }
+            case Operation::POP_BACK:
+                if (!m.empty()) {
+                    Timed([&] { v.PopBack(); });
+                    m.pop_back();
+                }
+                break;
+            case Operation::RESIZE: {
+                const size_t size = Random(MAX_SIZE);
+                Timed([&] { v.Resize(size); });
+                m.resize(size, 0);
+                break;
+            }
+            case Operation::RESIZE_VALUE: {
+                const size_t size = Random(MAX_SIZE);
+                if (!m.empty() && Random(2) == 0) {
+                    const size_t index = Random(m.size());
+                    const int id = m[index];
+                    Timed([&] { v.Resize(size, v[index]); });
+                    m.resize(size, id);
+                }
+                else {
+                    const int id = NextId();
+                    const T value(id);
+                    Timed([&] { v.Resize(size, value); });
+                    m.resize(size, id);
+                }
+                break;
+            }
+            case Operation::RESIZE_PARALLEL: {
+                const size_t size = Random(MAX_SIZE);
+                Timed([&] { v.Resize(STRESS_PARALLEL, size); });
+                m.resize(size, 0);
+                break;
+            }
+            case Operation::RESERVE: {
+                const size_t capacity = Random(MAX_SIZE * 2);
+                Timed([&] { v.Reserve(capacity); });
+                break;
+            }
+            case Operation::SHRINK_TO_FIT:
+                Timed([&] { v.ShrinkToFit(); });
+                break;
+            case Operation::COPY_ASSIGN:
+                Timed([&] { v = slots_[source]; });
+                m = models_[source];
+                break;
+            case Operation::COPY_PARALLEL:
+                Timed([&] { v.CopyFrom(STRESS_PARALLEL, slots_[source]); });
+                m = models_[source];
+                break;
+            case Operation::MOVE_ASSIGN:
+                Timed([&] { v = std::move(slots_[source]); });
+                m = models_[source];
+                // Перемещённый вектор корректен, но его содержимое не определено
+                Resync(source);
+                break;
+            case Operation::COPY_CONSTRUCT_PARALLEL: {
+                std::optional<Vec> copy;
+                Timed([&] { copy.emplace(STRESS_PARALLEL, slots_[source]); });
+                extra_ = copy->GetStats().Get();
+                v.Swap(*copy);
+                m = models_[source];
+                break;
+            }
+            case Operation::SWAP:
+                Timed([&] { v.Swap(slots_[source]); });
+                std::swap(m, models_[source]);
+                break;
+            case Operation::COUNT:
+                break;
+            }
+        }
+
+        // Операции, которые при исключении оставляют вектор без изменений. Вставка и удаление
+        // из середины сдвигают элементы перемещением, поэтому строгая гарантия возможна
+        // только для элементов с перемещением без исключений.
+        static bool IsStrong(Operation operation) {
+            switch (operation) {
+            case Operation::EMPLACE:
+            case Operation::INSERT_ELEMENT:
+            case Operation::ERASE:
+            case Operation::ERASE_RANGE:
+                return std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>;
+            case Operation::COPY_ASSIGN:
+            case Operation::COPY_PARALLEL:
+                return false;
+            default:
+                return true;
+            }
+        }
+
+        static bool Grows(Operation operation) {
+            switch (operation) {
+            case Operation::EMPLACE_BACK:
+            case Operation::PUSH_BACK_ELEMENT:
+            case Operation::EMPLACE:
+            case Operation::INSERT_ELEMENT:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        void Verify(size_t slot) const {
+            const Vec& v = slots_[slot];
+            const Model& m = models_[slot];
+            Require(v.Size() == m.size(), "size differs from std::vector");
+            Require(v.Size() <= v.Capacity(), "size exceeds capacity");
+            for (size_t i = 0; i < m.size(); ++i) {
+                Require(IdOf(v[i]) == m[i], "element differs from std::vector");
+            }
+        }
+
+        void Resync(size_t slot) {
+            Model& m = models_[slot];
+            m.clear();
+            for (const T& element : slots_[slot]) {
+                m.push_back(IdOf(element));
+            }
+        }
+
+        VectorStatsCounters TotalCounters() const {
+            VectorStatsCounters total;
+            for (const Vec& v : slots_) {
+                const VectorStatsCounters& counters = v.GetStats().Get();
+                total.allocations += counters.allocations;
+                total.reallocations += counters.reallocations;
+                total.expansions += counters.expansions;
+            }
+            return total;
+        }
+
+        void Print() const {
+            std::cout << "== " << name_ << " ==\n"
+                << std::left << std::setw(22) << "operation" << std::right
+                << std::setw(9) << "calls" << std::setw(9) << "faults" << std::setw(9) << "allocs"
+                << std::setw(9) << "reallocs" << std::setw(9) << "expands" << std::setw(10) << "ns/call" << '\n';
+            for (size_t i = 0; i < OPERATION_COUNT; ++i) {
+                const OperationStats& stats = stats_[i];
+                const double per_call = stats.calls == 0 ? 0.0
+                    : static_cast<double>(stats.time.count()) / static_cast<double>(stats.calls);
+                std::cout << std::left << std::setw(22) << OPERATION_NAMES[i] << std::right
+                    << std::setw(9) << stats.calls << std::setw(9) << stats.faults
+                    << std::setw(9) << stats.allocations << std::setw(9) << stats.reallocations
+                    << std::setw(9) << stats.expansions
+                    << std::setw(10) << std::fixed << std::setprecision(1) << per_call << '\n';
+            }
+        }
+
+        // Время учитывается только для вызова метода вектора, в том числе прерванного исключением
+        template <typename Fn>
+        void Timed(Fn fn) {
+            struct Timer {
+                ~Timer() {
+                    elapsed += std::chrono::steady_clock::now() - start;
+                }
+                std::chrono::nanoseconds& elapsed;
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            } timer{ elapsed_ };
+            fn();
+        }
+
+        size_t Random(size_t bound) {
+            return bound == 0 ? 0 : static_cast<size_t>(random_() % bound);
+        }
+
+        int NextId() {
+            return ++last_id_;
+        }
+
+        const char* name_;
+        std::mt19937_64& random_;
+        std::vector<Vec> slots_;
+        std::vector<Model> models_;
+        OperationStats stats_[OPERATION_COUNT];
+        VectorStatsCounters extra_;
+        std::chrono::nanoseconds elapsed_{ 0 };
+        int last_id_ = 0;
+    };
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t steps = argc > 1 ? std::stoul(argv[1]) : 100000;
+    const std::uint64_t seed = argc > 2 ? std::stoull(argv[2]) : std::random_device()();
+    context.seed = seed;
+    std::cout << "seed " << seed << ", " << steps << " operations per configuration\n";
+    std::mt19937_64 random(seed);
+
+    Harness<MovableElement>("MOVE relocation, std::allocator", random).Run(steps);
+    Harness<CopiedElement, std::allocator<CopiedElement>, OneAndHalfGrowth>(
+        "COPY relocation, throwing move", random).Run(steps);
+    Harness<RelocatableElement, MallocAllocator<RelocatableElement>>(
+        "BITWISE relocation, realloc", random).Run(steps);
+    {
+        Arena arena;
+        Harness<RelocatableElement, ArenaAllocator<RelocatableElement>>(
+            "BITWISE relocation, in-place growth", random, ArenaAllocator<RelocatableElement>(arena)).Run(steps);
+    }
+    Harness<int, MallocAllocator<int>, CacheLineGrowth>("trivially copyable, realloc", random).Run(steps);
+    std::cout << "OK" << std::endl;
+}
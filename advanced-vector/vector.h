@@ -1,230 +1,2295 @@
 #pragma once
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <initializer_list>
 #include <iterator>
+#include <limits>
+#include <mutex>
 #include <new>
+#include <thread>
+#include <type_traits>
 #include <utility>
 #include <memory>
 
+// В C++20 основные операции Vector и RawMemory доступны в константных выражениях:
+// таблицы можно строить на этапе компиляции (см. ToArray)
+#if defined(__cpp_constexpr_dynamic_alloc) && defined(__cpp_lib_constexpr_dynamic_alloc)
+#define VECTOR_CONSTEXPR constexpr
+#define VECTOR_HAS_CONSTEXPR 1
+#else
+#define VECTOR_CONSTEXPR
+#define VECTOR_HAS_CONSTEXPR 0
+#endif
+
+// Отладочный режим профиля кучи: если VECTOR_HEAP_PROFILE определён во всей программе,
+// каждый буфер RawMemory записывается за местом вызова, которое его выделило (см. heap_profile.h)
+#if defined(VECTOR_HEAP_PROFILE) && __has_include(<source_location>)
+#include <source_location>
+#endif
+
+// Тип, который можно перенести в другой буфер побитовым копированием без вызова
+// конструктора перемещения и деструктора исходного объекта. Специализируйте шаблон
+// для своих типов (например, для std::unique_ptr или дескрипторов ресурсов).
+template <typename T>
+struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {
+};
+
+template <typename T>
+inline constexpr bool IsTriviallyRelocatableV = IsTriviallyRelocatable<T>::value;
+
+// Способ, которым элементы переносятся в новый буфер
+enum class Relocation {
+	BITWISE,
+	MOVE,
+	COPY,
+};
+
+namespace detail {
+
+template <typename T>
+constexpr Relocation RelocationOf() noexcept {
+	if constexpr (IsTriviallyRelocatableV<T>) {
+		return Relocation::BITWISE;
+	}
+	else if constexpr (!std::is_copy_constructible_v<T> || std::is_nothrow_move_constructible_v<T>) {
+		return Relocation::MOVE;
+	}
+	else {
+		return Relocation::COPY;
+	}
+}
+
+// Ветки для константных выражений не нужны в рантайме: там остаются быстрые пути
+// через memcpy и алгоритмы <memory>
+constexpr bool IsConstantEvaluated() noexcept {
+#ifdef __cpp_lib_is_constant_evaluated
+	return std::is_constant_evaluated();
+#else
+	return false;
+#endif
+}
+
+#ifdef VECTOR_HEAP_PROFILE
+// Место вызова, которому приписываются выделения памяти. Передаётся аргументом
+// по умолчанию, поэтому указывает на код, вызвавший метод вектора.
+struct SourceSite {
+#ifdef __cpp_lib_source_location
+	static constexpr SourceSite Current(std::source_location location = std::source_location::current()) noexcept {
+		return { location.file_name(), location.function_name(), location.line() };
+	}
+#else
+	static constexpr SourceSite Current(const char* file = __builtin_FILE(),
+		const char* function = __builtin_FUNCTION(), unsigned line = __builtin_LINE()) noexcept {
+		return { file, function, line };
+	}
+#endif
+
+	const char* file = nullptr;
+	const char* function = nullptr;
+	unsigned line = 0;
+};
+
+// Определены в heap_profile.h
+inline SourceSite& CurrentSite() noexcept;
+inline void HeapProfileAllocate(const void* block, size_t capacity, size_t bytes) noexcept;
+inline void HeapProfileResize(const void* block, size_t capacity, size_t bytes) noexcept;
+inline void HeapProfileDeallocate(std::uintptr_t address) noexcept;
+inline void HeapProfileReallocate(const void* block) noexcept;
+#else
+// Без профиля место вызова не хранится и не занимает места
+struct SourceSite {
+	static constexpr SourceSite Current() noexcept {
+		return {};
+	}
+};
+#endif
+
+// Назначает место вызова выделениям внутри своей области видимости. Внешняя область
+// главнее вложенной: Resize, вызывающий Reserve, записывает место вызова Resize.
+class SiteScope {
+public:
+	VECTOR_CONSTEXPR explicit SiteScope([[maybe_unused]] SourceSite site) noexcept {
+#ifdef VECTOR_HEAP_PROFILE
+		if (!IsConstantEvaluated() && CurrentSite().file == nullptr) {
+			CurrentSite() = site;
+			owner_ = true;
+		}
+#endif
+	}
+
+	SiteScope(const SiteScope&) = delete;
+	SiteScope& operator=(const SiteScope&) = delete;
+
+	VECTOR_CONSTEXPR ~SiteScope() {
+#ifdef VECTOR_HEAP_PROFILE
+		if (owner_) {
+			CurrentSite() = SourceSite();
+		}
+#endif
+	}
+
+#ifdef VECTOR_HEAP_PROFILE
+private:
+	bool owner_ = false;
+#endif
+};
+
+// События буферов для профиля кучи. Без профиля и на этапе компиляции ничего не делают.
+inline VECTOR_CONSTEXPR void ProfileAllocate([[maybe_unused]] const void* block, [[maybe_unused]] size_t capacity,
+	[[maybe_unused]] size_t bytes) noexcept {
+#ifdef VECTOR_HEAP_PROFILE
+	if (!IsConstantEvaluated()) {
+		HeapProfileAllocate(block, capacity, bytes);
+	}
+#endif
+}
+
+inline VECTOR_CONSTEXPR void ProfileResize([[maybe_unused]] const void* block, [[maybe_unused]] size_t capacity,
+	[[maybe_unused]] size_t bytes) noexcept {
+#ifdef VECTOR_HEAP_PROFILE
+	if (!IsConstantEvaluated()) {
+		HeapProfileResize(block, capacity, bytes);
+	}
+#endif
+}
+
+inline VECTOR_CONSTEXPR void ProfileDeallocate([[maybe_unused]] const void* block) noexcept {
+#ifdef VECTOR_HEAP_PROFILE
+	if (!IsConstantEvaluated()) {
+		HeapProfileDeallocate(reinterpret_cast<std::uintptr_t>(block));
+	}
+#endif
+}
+
+// Для блока, который уже мог быть освобождён: адрес сохранён числом заранее
+inline void ProfileDeallocateAddress([[maybe_unused]] std::uintptr_t address) noexcept {
+#ifdef VECTOR_HEAP_PROFILE
+	HeapProfileDeallocate(address);
+#endif
+}
+
+inline VECTOR_CONSTEXPR void ProfileReallocate([[maybe_unused]] const void* block) noexcept {
+#ifdef VECTOR_HEAP_PROFILE
+	if (!IsConstantEvaluated()) {
+		HeapProfileReallocate(block);
+	}
+#endif
+}
+
+template <typename T, typename... Args>
+VECTOR_CONSTEXPR T* ConstructAt(T* p, Args&&... args) {
+#if VECTOR_HAS_CONSTEXPR
+	return std::construct_at(p, std::forward<Args>(args)...);
+#else
+	return new(p) T(std::forward<Args>(args)...);
+#endif
+}
+
+// Алгоритмы <memory>, которые в C++20 ещё не constexpr. При вычислении на этапе компиляции
+// исключение прерывает компиляцию, поэтому откатывать созданные элементы не нужно.
+template <typename T>
+VECTOR_CONSTEXPR void UninitializedValueConstructN(T* first, size_t n) {
+	if (IsConstantEvaluated()) {
+		for (size_t i = 0; i < n; ++i) {
+			ConstructAt(first + i);
+		}
+	}
+	else {
+		std::uninitialized_value_construct_n(first, n);
+	}
+}
+
+template <typename T>
+VECTOR_CONSTEXPR void UninitializedFillN(T* first, size_t n, const T& value) {
+	if (IsConstantEvaluated()) {
+		for (size_t i = 0; i < n; ++i) {
+			ConstructAt(first + i, value);
+		}
+	}
+	else {
+		std::uninitialized_fill_n(first, n, value);
+	}
+}
+
+template <typename T>
+VECTOR_CONSTEXPR void UninitializedCopyN(const T* first, size_t n, T* d_first) {
+	if (IsConstantEvaluated()) {
+		for (size_t i = 0; i < n; ++i) {
+			ConstructAt(d_first + i, first[i]);
+		}
+	}
+	else {
+		std::uninitialized_copy_n(first, n, d_first);
+	}
+}
+
+template <typename T>
+VECTOR_CONSTEXPR void UninitializedMoveN(T* first, size_t n, T* d_first) {
+	if (IsConstantEvaluated()) {
+		for (size_t i = 0; i < n; ++i) {
+			ConstructAt(d_first + i, std::move(first[i]));
+		}
+	}
+	else {
+		std::uninitialized_move_n(first, n, d_first);
+	}
+}
+
+template <typename T>
+VECTOR_CONSTEXPR void DestroyN(T* first, size_t n) noexcept {
+	if constexpr (!std::is_trivially_destructible_v<T>) {
+		std::destroy_n(first, n);
+	}
+}
+
+// Побитовый перенос на этапе компиляции: перемещение с немедленным разрушением исходного
+// элемента. Если диапазоны лежат в одном буфере и d_first правее first, перенос идёт с конца.
+template <typename T>
+constexpr void ConstexprRelocate(T* first, size_t n, T* d_first, bool backward = false) {
+	if (backward) {
+		for (size_t i = n; i-- > 0;) {
+			ConstructAt(d_first + i, std::move(first[i]));
+			std::destroy_at(first + i);
+		}
+	}
+	else {
+		for (size_t i = 0; i < n; ++i) {
+			ConstructAt(d_first + i, std::move(first[i]));
+			std::destroy_at(first + i);
+		}
+	}
+}
+
+// Переносит n элементов в неинициализированную память d_first. Если побитовый перенос
+// невозможен, исходные элементы остаются живыми и должны быть разрушены DestroyRelocated.
+template <typename T>
+VECTOR_CONSTEXPR void UninitializedRelocate(T* first, size_t n, T* d_first) {
+	if constexpr (RelocationOf<T>() == Relocation::BITWISE) {
+		if (IsConstantEvaluated()) {
+			ConstexprRelocate(first, n, d_first);
+		}
+		else if (n != 0) {
+			std::memcpy(static_cast<void*>(d_first), static_cast<const void*>(first), n * sizeof(T));
+		}
+	}
+	else if constexpr (RelocationOf<T>() == Relocation::MOVE) {
+		UninitializedMoveN(first, n, d_first);
+	}
+	else {
+		UninitializedCopyN(first, n, d_first);
+	}
+}
+
+template <typename T>
+VECTOR_CONSTEXPR void DestroyRelocated(T* first, size_t n) noexcept {
+	if constexpr (!IsTriviallyRelocatableV<T>) {
+		DestroyN(first, n);
+	}
+}
+
+// Сдвигает n живых элементов внутри одного буфера, диапазоны могут перекрываться
+template <typename T>
+VECTOR_CONSTEXPR void RelocateOverlapping(T* first, size_t n, T* d_first) noexcept {
+	static_assert(IsTriviallyRelocatableV<T>);
+	if (IsConstantEvaluated()) {
+		ConstexprRelocate(first, n, d_first, first < d_first);
+	}
+	else if (n != 0) {
+		std::memmove(static_cast<void*>(d_first), static_cast<const void*>(first), n * sizeof(T));
+	}
+}
+
+// Транзакционный перенос в новый буфер. Сначала construct(new_first + distance) создаёт
+// gap новых элементов (при исключении construct сам разрушает созданное), затем элементы
+// [first, first + size) переносятся в new_first в обход созданных. Если что-то выбросило
+// исключение, всё созданное в новом буфере разрушается, а исходные элементы не меняются:
+// перенос перемещением выбирается, только если оно не выбрасывает исключений или
+// копирование невозможно. После успеха исходные элементы освобождаются DestroyRelocated.
+template <typename T, typename Construct>
+VECTOR_CONSTEXPR void RelocateInto(T* first, size_t size, T* new_first, size_t distance, size_t gap, Construct&& construct) {
+	assert(distance <= size);
+	std::forward<Construct>(construct)(new_first + distance);
+	try {
+		UninitializedRelocate(first, distance, new_first);
+		try {
+			UninitializedRelocate(first + distance, size - distance, new_first + distance + gap);
+		}
+		catch (...) {
+			DestroyN(new_first, distance);
+			throw;
+		}
+	}
+	catch (...) {
+		DestroyN(new_first + distance, gap);
+		throw;
+	}
+}
+
+template <typename A, typename = void>
+struct HasAllocateAtLeast : std::false_type {
+};
+
+template <typename A>
+struct HasAllocateAtLeast<A, std::void_t<decltype(std::declval<A&>().allocate_at_least(size_t{}))>>
+	: std::true_type {
+};
+
+template <typename A, typename T, typename = void>
+struct HasTryExpand : std::false_type {
+};
+
+template <typename A, typename T>
+struct HasTryExpand<A, T, std::void_t<decltype(std::declval<A&>().try_expand(
+	std::declval<T*>(), size_t{}, size_t{}))>> : std::true_type {
+};
+
+template <typename A, typename T, typename = void>
+struct HasReallocate : std::false_type {
+};
+
+template <typename A, typename T>
+struct HasReallocate<A, T, std::void_t<decltype(std::declval<A&>().reallocate(
+	std::declval<T*>(), size_t{}, size_t{}))>> : std::true_type {
+};
+
+template <typename It>
+using IteratorCategory = typename std::iterator_traits<It>::iterator_category;
+
+template <typename It, typename = void>
+struct IsInputIterator : std::false_type {
+};
+
+template <typename It>
+struct IsInputIterator<It, std::void_t<IteratorCategory<It>>>
+	: std::is_convertible<IteratorCategory<It>, std::input_iterator_tag> {
+};
+
+template <typename It>
+using RequireInputIterator = std::enable_if_t<IsInputIterator<It>::value>;
+
+template <typename It>
+inline constexpr bool IsForwardIteratorV = std::is_convertible_v<IteratorCategory<It>, std::forward_iterator_tag>;
+
+// Итератор, n раз повторяющий одно значение
+template <typename T>
+class RepeatIterator {
+public:
+	using iterator_category = std::forward_iterator_tag;
+	using value_type = T;
+	using difference_type = std::ptrdiff_t;
+	using pointer = const T*;
+	using reference = const T&;
+
+	RepeatIterator(const T& value, size_t index) noexcept
+		: value_(&value)
+		, index_(index) {
+	}
+
+	reference operator*() const noexcept {
+		return *value_;
+	}
+	pointer operator->() const noexcept {
+		return value_;
+	}
+	RepeatIterator& operator++() noexcept {
+		++index_;
+		return *this;
+	}
+	RepeatIterator operator++(int) noexcept {
+		RepeatIterator old = *this;
+		++index_;
+		return old;
+	}
+	bool operator==(const RepeatIterator& other) const noexcept {
+		return index_ == other.index_;
+	}
+	bool operator!=(const RepeatIterator& other) const noexcept {
+		return index_ != other.index_;
+	}
+
+private:
+	const T* value_;
+	size_t index_;
+};
+
+// Номер старшего установленного бита; value должно быть больше нуля
+constexpr size_t FloorLog2(size_t value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+	return std::numeric_limits<unsigned long long>::digits - 1 - __builtin_clzll(value);
+#else
+	size_t result = 0;
+	while (value >>= 1) {
+		++result;
+	}
+	return result;
+#endif
+}
+
+}  // namespace detail
+
+// Хранит элементы в памяти malloc. Умеет переносить блок через realloc: для больших
+// блоков glibc делает это через mremap, не копируя страницы и не удваивая пиковое потребление.
+template <typename T>
+struct MallocAllocator {
+	using value_type = T;
+
+	static_assert(alignof(T) <= alignof(std::max_align_t));
+
+	MallocAllocator() = default;
+	template <typename U>
+	MallocAllocator(const MallocAllocator<U>&) noexcept {
+	}
+
+	T* allocate(size_t n) {
+		return static_cast<T*>(CheckedResult(std::malloc(ByteSize(n))));
+	}
+
+	void deallocate(T* p, size_t /*n*/) noexcept {
+		std::free(p);
+	}
+
+	// Содержимое блока переносится побитово, поэтому годится только для побитово переносимых T
+	T* reallocate(T* p, size_t /*old_n*/, size_t new_n) {
+		return static_cast<T*>(CheckedResult(std::realloc(static_cast<void*>(p), ByteSize(new_n))));
+	}
+
+	bool operator==(const MallocAllocator&) const noexcept {
+		return true;
+	}
+	bool operator!=(const MallocAllocator&) const noexcept {
+		return false;
+	}
+
+private:
+	static size_t ByteSize(size_t n) {
+		if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+			throw std::bad_alloc();
+		}
+		return n * sizeof(T);
+	}
+
+	static void* CheckedResult(void* p) {
+		if (p == nullptr) {
+			throw std::bad_alloc();
+		}
+		return p;
+	}
+};
+
+// Выделяет память, выровненную по границе Align байт, через выровненные operator new/delete.
+// Вместимость округляется вверх до целого числа блоков по Align байт, поэтому SIMD-цикл
+// может обработать хвост полной загрузкой без скалярного эпилога.
+template <typename T, size_t Align = 64>
+struct AlignedAllocator {
+	static_assert(Align >= alignof(T) && (Align & (Align - 1)) == 0,
+		"Align must be a power of two not less than alignof(T)");
+
+	using value_type = T;
+
+	static constexpr size_t ALIGNMENT = Align;
+
+	template <typename U>
+	struct rebind {
+		using other = AlignedAllocator<U, Align>;
+	};
+
+	struct AllocationResult {
+		T* ptr;
+		size_t count;
+	};
+
+	AlignedAllocator() = default;
+	template <typename U>
+	AlignedAllocator(const AlignedAllocator<U, Align>&) noexcept {
+	}
+
+	AllocationResult allocate_at_least(size_t n) {
+		const size_t bytes = (ByteSize(n) + Align - 1) / Align * Align;
+		const size_t count = bytes / sizeof(T);
+		return { allocate(count), count };
+	}
+
+	T* allocate(size_t n) {
+		return static_cast<T*>(::operator new(ByteSize(n), std::align_val_t{ Align }));
+	}
+
+	void deallocate(T* p, size_t n) noexcept {
+		::operator delete(static_cast<void*>(p), n * sizeof(T), std::align_val_t{ Align });
+	}
+
+	bool operator==(const AlignedAllocator&) const noexcept {
+		return true;
+	}
+	bool operator!=(const AlignedAllocator&) const noexcept {
+		return false;
+	}
+
+private:
+	static size_t ByteSize(size_t n) {
+		if (n > (std::numeric_limits<size_t>::max() - Align) / sizeof(T)) {
+			throw std::bad_alloc();
+		}
+		return n * sizeof(T);
+	}
+};
+
+// Кэш освобождённых блоков памяти текущего потока. Блоки разбиты на классы размеров
+// по степеням двойки, общий объём кэша ограничен CapacityBytes(). Используется RecyclingAllocator.
+class BufferCache {
+	struct Block {
+		Block* next;
+	};
+
+	static constexpr size_t MIN_BLOCK_BYTES = 16;
+
+public:
+	static constexpr size_t DEFAULT_CAPACITY_BYTES = 4 << 20;
+
+	static BufferCache& Local() noexcept {
+		thread_local BufferCache cache;
+		// При завершении потока блоки освобождаются, а более поздние освобождения идут мимо кэша
+		thread_local struct ThreadExit {
+			~ThreadExit() {
+				cache.SetCapacityBytes(0);
+			}
+		} thread_exit;
+		(void)thread_exit;
+		return cache;
+	}
+
+	BufferCache(const BufferCache&) = delete;
+	BufferCache& operator=(const BufferCache&) = delete;
+
+	// Размер блока, который выделяется для запроса bytes байт
+	static size_t SizeClass(size_t bytes) {
+		if (bytes <= MIN_BLOCK_BYTES) {
+			return MIN_BLOCK_BYTES;
+		}
+		if (bytes > std::numeric_limits<size_t>::max() / 2 + 1) {
+			throw std::bad_alloc();
+		}
+		return size_t{ 1 } << (detail::FloorLog2(bytes - 1) + 1);
+	}
+
+	// bytes должен быть результатом SizeClass
+	void* Allocate(size_t bytes) {
+		Block*& head = buckets_[detail::FloorLog2(bytes)];
+		if (head != nullptr) {
+			Block* block = std::exchange(head, head->next);
+			cached_bytes_ -= bytes;
+			++hits_;
+			return block;
+		}
+		++misses_;
+		return ::operator new(bytes);
+	}
+
+	void Deallocate(void* p, size_t bytes) noexcept {
+		if (cached_bytes_ + bytes > capacity_bytes_) {
+			::operator delete(p, bytes);
+			return;
+		}
+		Block*& head = buckets_[detail::FloorLog2(bytes)];
+		head = new(p) Block{ head };
+		cached_bytes_ += bytes;
+	}
+
+	// Возвращает все закэшированные блоки в кучу
+	void Trim() noexcept {
+		for (size_t size_class = 0; size_class < BUCKETS; ++size_class) {
+			while (buckets_[size_class] != nullptr) {
+				Block* block = std::exchange(buckets_[size_class], buckets_[size_class]->next);
+				::operator delete(static_cast<void*>(block), size_t{ 1 } << size_class);
+			}
+		}
+		cached_bytes_ = 0;
+	}
+
+	void SetCapacityBytes(size_t capacity_bytes) noexcept {
+		capacity_bytes_ = capacity_bytes;
+		if (cached_bytes_ > capacity_bytes_) {
+			Trim();
+		}
+	}
+
+	size_t CapacityBytes() const noexcept {
+		return capacity_bytes_;
+	}
+
+	size_t CachedBytes() const noexcept {
+		return cached_bytes_;
+	}
+
+	// Выделения, обслуженные из кэша и из кучи
+	size_t Hits() const noexcept {
+		return hits_;
+	}
+
+	size_t Misses() const noexcept {
+		return misses_;
+	}
+
+private:
+	BufferCache() = default;
+
+	static constexpr size_t BUCKETS = std::numeric_limits<size_t>::digits;
+
+	Block* buckets_[BUCKETS] = {};
+	size_t cached_bytes_ = 0;
+	size_t capacity_bytes_ = DEFAULT_CAPACITY_BYTES;
+	size_t hits_ = 0;
+	size_t misses_ = 0;
+};
+
+// Берёт блоки из BufferCache текущего потока и возвращает их туда же. Вместимость
+// округляется до класса размера, поэтому векторы с похожим пиковым размером
+// переиспользуют одни и те же блоки без обращения к куче.
 template <typename T>
+struct RecyclingAllocator {
+	static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+
+	using value_type = T;
+
+	struct AllocationResult {
+		T* ptr;
+		size_t count;
+	};
+
+	RecyclingAllocator() = default;
+	template <typename U>
+	RecyclingAllocator(const RecyclingAllocator<U>&) noexcept {
+	}
+
+	AllocationResult allocate_at_least(size_t n) {
+		const size_t bytes = BufferCache::SizeClass(ByteSize(n));
+		return { static_cast<T*>(BufferCache::Local().Allocate(bytes)), bytes / sizeof(T) };
+	}
+
+	T* allocate(size_t n) {
+		return static_cast<T*>(BufferCache::Local().Allocate(BufferCache::SizeClass(ByteSize(n))));
+	}
+
+	void deallocate(T* p, size_t n) noexcept {
+		BufferCache::Local().Deallocate(p, BufferCache::SizeClass(n * sizeof(T)));
+	}
+
+	bool operator==(const RecyclingAllocator&) const noexcept {
+		return true;
+	}
+	bool operator!=(const RecyclingAllocator&) const noexcept {
+		return false;
+	}
+
+private:
+	static size_t ByteSize(size_t n) {
+		if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+			throw std::bad_alloc();
+		}
+		return n * sizeof(T);
+	}
+};
+
+namespace detail {
+
+template <typename Alloc, typename = void>
+struct AllocatorAlignment : std::integral_constant<size_t, alignof(typename Alloc::value_type)> {
+};
+
+template <typename Alloc>
+struct AllocatorAlignment<Alloc, std::void_t<decltype(Alloc::ALIGNMENT)>>
+	: std::integral_constant<size_t, Alloc::ALIGNMENT> {
+};
+
+template <size_t Align, typename T>
+T* AssumeAligned(T* ptr) noexcept {
+	assert(reinterpret_cast<std::uintptr_t>(ptr) % Align == 0);
+#if defined(__GNUC__) || defined(__clang__)
+	return static_cast<T*>(__builtin_assume_aligned(ptr, Align));
+#elif defined(__cpp_lib_assume_aligned)
+	return ptr == nullptr ? ptr : std::assume_aligned<Align>(ptr);
+#else
+	return ptr;
+#endif
+}
+
+}  // namespace detail
+
+template <typename T, typename Alloc = std::allocator<T>>
 class RawMemory {
+	using AllocTraits = std::allocator_traits<Alloc>;
+
 public:
+	using allocator_type = Alloc;
+
+	static_assert(std::is_same_v<typename AllocTraits::value_type, T>);
+
 	RawMemory() = default;
 
-	explicit RawMemory(size_t capacity)
-		: buffer_(Allocate(capacity))
-		, capacity_(capacity) {
+	VECTOR_CONSTEXPR explicit RawMemory(const Alloc& alloc) noexcept
+		: alloc_(alloc) {
+	}
+
+	VECTOR_CONSTEXPR explicit RawMemory(size_t capacity, const Alloc& alloc = Alloc())
+		: alloc_(alloc) {
+		Allocate(capacity);
+	}
+
+	// Принимает во владение буфер на capacity элементов, выделенный аллокатором, равным alloc
+	VECTOR_CONSTEXPR static RawMemory FromRawBuffer(T* buffer, size_t capacity, const Alloc& alloc = Alloc()) noexcept {
+		RawMemory memory(alloc);
+		memory.buffer_ = buffer;
+		memory.capacity_ = buffer != nullptr ? capacity : 0;
+		return memory;
+	}
+
+	// Отказывается от владения буфером; освободить его должен вызывающий через аллокатор
+	VECTOR_CONSTEXPR T* Release() noexcept {
+		detail::ProfileDeallocate(buffer_);
+		capacity_ = 0;
+		return std::exchange(buffer_, nullptr);
+	}
+
+	RawMemory(const RawMemory& other) = delete;
+	RawMemory& operator=(const RawMemory& other) = delete;
+	VECTOR_CONSTEXPR RawMemory(RawMemory&& other) noexcept
+		: alloc_(std::move(other.alloc_))
+		, buffer_(std::exchange(other.buffer_, nullptr))
+		, capacity_(std::exchange(other.capacity_, 0)) {
+	}
+	VECTOR_CONSTEXPR RawMemory& operator=(RawMemory&& other) noexcept {
+		if (this != &other) {
+			Swap(other);
+		}
+		return *this;
+	}
+
+	VECTOR_CONSTEXPR ~RawMemory() {
+		Deallocate();
+	}
+
+	VECTOR_CONSTEXPR T* operator+(size_t offset) noexcept {
+		assert(offset <= capacity_);
+		return buffer_ + offset;
+	}
+
+	VECTOR_CONSTEXPR const T* operator+(size_t offset) const noexcept {
+		return const_cast<RawMemory&>(*this) + offset;
+	}
+
+	VECTOR_CONSTEXPR const T& operator[](size_t index) const noexcept {
+		return const_cast<RawMemory&>(*this)[index];
+	}
+
+	VECTOR_CONSTEXPR T& operator[](size_t index) noexcept {
+		assert(index < capacity_);
+		return buffer_[index];
+	}
+
+	// Буфер всегда обменивается вместе с аллокатором, которым он был выделен
+	VECTOR_CONSTEXPR void Swap(RawMemory& other) noexcept {
+		using std::swap;
+		swap(alloc_, other.alloc_);
+		std::swap(buffer_, other.buffer_);
+		std::swap(capacity_, other.capacity_);
+	}
+
+	VECTOR_CONSTEXPR const T* GetAddress() const noexcept {
+		return buffer_;
+	}
+
+	VECTOR_CONSTEXPR T* GetAddress() noexcept {
+		return buffer_;
+	}
+
+	VECTOR_CONSTEXPR size_t Capacity() const {
+		return capacity_;
+	}
+
+	VECTOR_CONSTEXPR const Alloc& GetAllocator() const noexcept {
+		return alloc_;
+	}
+
+	// Размер выделенного блока в байтах
+	VECTOR_CONSTEXPR size_t MemoryUsage() const noexcept {
+		return capacity_ * sizeof(T);
+	}
+
+	// Байты блока, не занятые первыми size элементами
+	VECTOR_CONSTEXPR size_t SlackBytes(size_t size) const noexcept {
+		assert(size <= capacity_);
+		return (capacity_ - size) * sizeof(T);
+	}
+
+	// Пытается увеличить блок на месте, если аллокатор это поддерживает. Элементы не двигаются.
+	VECTOR_CONSTEXPR bool TryExpand(size_t capacity) noexcept {
+		if constexpr (detail::HasTryExpand<Alloc, T>::value) {
+			if (buffer_ != nullptr && capacity > capacity_
+				&& alloc_.try_expand(buffer_, capacity_, capacity)) {
+				capacity_ = capacity;
+				detail::ProfileResize(buffer_, capacity_, MemoryUsage());
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Переносит блок средствами аллокатора с побитовым копированием содержимого.
+	// При исключении блок остаётся нетронутым.
+	VECTOR_CONSTEXPR void Reallocate(size_t capacity) {
+		static_assert(detail::HasReallocate<Alloc, T>::value);
+		// При исключении старый блок жив и остаётся в профиле. После успешного переноса старый
+		// адрес недействителен, поэтому для профиля он сохраняется заранее в виде числа.
+		[[maybe_unused]] const std::uintptr_t old_block = reinterpret_cast<std::uintptr_t>(buffer_);
+		buffer_ = alloc_.reallocate(buffer_, capacity_, capacity);
+		detail::ProfileDeallocateAddress(old_block);
+		capacity_ = capacity;
+		detail::ProfileAllocate(buffer_, capacity_, MemoryUsage());
+	}
+
+private:
+	// Если аллокатор умеет возвращать блок с запасом, весь запас становится вместимостью
+	VECTOR_CONSTEXPR void Allocate(size_t n) {
+		if (n == 0) {
+			return;
+		}
+		if constexpr (detail::HasAllocateAtLeast<Alloc>::value) {
+			auto result = alloc_.allocate_at_least(n);
+			buffer_ = result.ptr;
+			capacity_ = result.count;
+		}
+		else {
+			buffer_ = AllocTraits::allocate(alloc_, n);
+			capacity_ = n;
+		}
+		detail::ProfileAllocate(buffer_, capacity_, MemoryUsage());
+	}
+
+	VECTOR_CONSTEXPR void Deallocate() noexcept {
+		if (buffer_ != nullptr) {
+			detail::ProfileDeallocate(buffer_);
+			AllocTraits::deallocate(alloc_, buffer_, capacity_);
+		}
+	}
+
+	[[no_unique_address]] Alloc alloc_;
+	T* buffer_ = nullptr;
+	size_t capacity_ = 0;
+};
+
+// Тег конструктора и методов, оставляющих элементы тривиальных типов неинициализированными
+struct DefaultInitTag {
+	explicit DefaultInitTag() = default;
+};
+
+inline constexpr DefaultInitTag DEFAULT_INIT{};
+
+// Тег конструкторов и методов, которые конструируют, копируют и разрушают элементы
+// в нескольких потоках. Диапазон делится на части не короче min_chunk элементов,
+// по одной на поток.
+struct ParallelTag {
+	size_t threads = 0;  // 0 — std::thread::hardware_concurrency()
+	size_t min_chunk = 1 << 16;
+};
+
+inline constexpr ParallelTag PARALLEL{};
+
+namespace detail {
+
+// Один поток без накладных расходов: так реализованы последовательные версии операций
+inline constexpr ParallelTag SEQUENTIAL{ 1, 1 };
+
+inline size_t ChunkCount(const ParallelTag& policy, size_t count) noexcept {
+	size_t threads = policy.threads;
+	if (threads == 0) {
+		threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	}
+	return std::max<size_t>(std::min(threads, count / std::max<size_t>(policy.min_chunk, 1)), 1);
+}
+
+inline size_t ChunkBegin(size_t count, size_t chunks, size_t chunk) noexcept {
+	return count / chunks * chunk + std::min(chunk, count % chunks);
+}
+
+// Вызывает fn(chunk, first, last) для каждой части диапазона [0, count). Первую часть
+// выполняет вызывающий поток; если создать поток не удалось, он же выполняет оставшиеся части.
+template <typename Fn>
+void RunChunks(size_t count, size_t chunks, Fn fn) noexcept {
+	auto run = [&fn, count, chunks](size_t chunk) noexcept {
+		fn(chunk, ChunkBegin(count, chunks, chunk), ChunkBegin(count, chunks, chunk + 1));
+	};
+	std::unique_ptr<std::thread[]> threads;
+	size_t started = 1;
+	try {
+		threads.reset(new std::thread[chunks]);
+		for (; started < chunks; ++started) {
+			threads[started] = std::thread(run, started);
+		}
+	}
+	catch (...) {
+	}
+	run(0);
+	for (size_t chunk = started; chunk < chunks; ++chunk) {
+		run(chunk);
+	}
+	for (size_t chunk = 1; chunk < started; ++chunk) {
+		threads[chunk].join();
+	}
+}
+
+// Выполняет op(first, last) для частей диапазона [0, count) в нескольких потоках.
+// Если какая-то часть выбросила исключение, для завершившихся без ошибок частей вызывается
+// rollback(first, last), а первое исключение пробрасывается дальше. Часть, выбросившая
+// исключение, сама отвечает за свою отмену, как std::uninitialized_copy_n.
+template <typename Op, typename Rollback>
+void ParallelChunks(const ParallelTag& policy, size_t count, Op op, Rollback rollback) {
+	const size_t chunks = ChunkCount(policy, count);
+	if (chunks == 1) {
+		op(size_t{ 0 }, count);
+		return;
+	}
+	std::unique_ptr<std::exception_ptr[]> errors(new std::exception_ptr[chunks]);
+	RunChunks(count, chunks, [&op, &errors](size_t chunk, size_t first, size_t last) noexcept {
+		try {
+			op(first, last);
+		}
+		catch (...) {
+			errors[chunk] = std::current_exception();
+		}
+	});
+	const auto failed = std::find_if(errors.get(), errors.get() + chunks,
+		[](const std::exception_ptr& error) { return error != nullptr; });
+	if (failed == errors.get() + chunks) {
+		return;
+	}
+	for (size_t chunk = 0; chunk < chunks; ++chunk) {
+		if (!errors[chunk]) {
+			rollback(ChunkBegin(count, chunks, chunk), ChunkBegin(count, chunks, chunk + 1));
+		}
+	}
+	std::rethrow_exception(*failed);
+}
+
+// На этапе компиляции параллельные операции выполняются последовательно
+template <typename T>
+VECTOR_CONSTEXPR void ParallelValueConstructN(const ParallelTag& policy, T* first, size_t count) {
+	if (IsConstantEvaluated()) {
+		UninitializedValueConstructN(first, count);
+		return;
+	}
+	ParallelChunks(policy, count,
+		[first](size_t begin, size_t end) { std::uninitialized_value_construct_n(first + begin, end - begin); },
+		[first](size_t begin, size_t end) noexcept { DestroyN(first + begin, end - begin); });
+}
+
+template <typename T>
+VECTOR_CONSTEXPR void ParallelCopyN(const ParallelTag& policy, const T* from, size_t count, T* to) {
+	if (IsConstantEvaluated()) {
+		UninitializedCopyN(from, count, to);
+		return;
+	}
+	ParallelChunks(policy, count,
+		[from, to](size_t begin, size_t end) { std::uninitialized_copy_n(from + begin, end - begin, to + begin); },
+		[to](size_t begin, size_t end) noexcept { DestroyN(to + begin, end - begin); });
+}
+
+template <typename T>
+VECTOR_CONSTEXPR void ParallelDestroyN(const ParallelTag& policy, T* first, size_t count) noexcept {
+	if constexpr (!std::is_trivially_destructible_v<T>) {
+		if (IsConstantEvaluated()) {
+			DestroyN(first, count);
+			return;
+		}
+		const size_t chunks = ChunkCount(policy, count);
+		RunChunks(count, chunks, [first](size_t /*chunk*/, size_t begin, size_t end) noexcept {
+			DestroyN(first + begin, end - begin);
+		});
+	}
+}
+
+}  // namespace detail
+
+// Невладеющее представление непрерывного диапазона элементов. Строится из указателя
+// и размера или из любого контейнера, у которого begin() возвращает указатель, а Size() —
+// количество элементов (Vector, SmallVector, MappedVector).
+template <typename T>
+class VectorView {
+public:
+	using iterator = T*;
+	using const_iterator = T*;
+
+	VectorView() = default;
+
+	VectorView(T* data, size_t size) noexcept
+		: data_(data)
+		, size_(size) {
+	}
+
+	template <typename Container, typename = std::enable_if_t<
+		std::is_convertible_v<decltype(std::declval<Container&>().begin()), T*>>>
+	VectorView(Container& container) noexcept
+		: data_(container.begin())
+		, size_(container.Size()) {
+	}
+
+	template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+	VectorView(VectorView<U> other) noexcept
+		: data_(other.Data())
+		, size_(other.Size()) {
+	}
+
+	T* begin() const noexcept {
+		return data_;
+	}
+	T* end() const noexcept {
+		return data_ + size_;
+	}
+
+	T* Data() const noexcept {
+		return data_;
+	}
+
+	size_t Size() const noexcept {
+		return size_;
+	}
+
+	bool Empty() const noexcept {
+		return size_ == 0;
+	}
+
+	size_t SizeBytes() const noexcept {
+		return size_ * sizeof(T);
+	}
+
+	T& operator[](size_t index) const noexcept {
+		assert(index < size_);
+		return data_[index];
+	}
+
+	// Представление count элементов, начиная с offset; count обрезается до конца диапазона
+	VectorView Subview(size_t offset, size_t count = std::numeric_limits<size_t>::max()) const noexcept {
+		assert(offset <= size_);
+		return VectorView(data_ + offset, std::min(count, size_ - offset));
+	}
+
+private:
+	T* data_ = nullptr;
+	size_t size_ = 0;
+};
+
+// Политика роста вычисляет вместимость нового буфера, когда в заполненный вектор
+// добавляется элемент. Результат должен быть больше текущей вместимости capacity.
+struct DoublingGrowth {
+	static constexpr size_t NextCapacity(size_t capacity, size_t /*element_size*/) noexcept {
+		return capacity == 0 ? 1 : capacity * 2;
+	}
+};
+
+// Рост в Num/Den раз
+template <size_t Num, size_t Den>
+struct GeometricGrowth {
+	static_assert(Den > 0 && Num > Den);
+
+	static constexpr size_t NextCapacity(size_t capacity, size_t /*element_size*/) noexcept {
+		return std::max(capacity + 1, capacity / Den * Num + capacity % Den * Num / Den);
+	}
+};
+
+using OneAndHalfGrowth = GeometricGrowth<3, 2>;
+
+// Первая аллокация вмещает не меньше MinElements элементов и не меньше MinBytes байт
+template <typename Base, size_t MinElements, size_t MinBytes = 0>
+struct MinimumFirstAllocation {
+	static constexpr size_t NextCapacity(size_t capacity, size_t element_size) noexcept {
+		const size_t next = Base::NextCapacity(capacity, element_size);
+		return std::max({ next, MinElements, MinBytes / element_size });
+	}
+};
+
+inline constexpr size_t CACHE_LINE_BYTES = 64;
+inline constexpr size_t PAGE_BYTES = 4096;
+inline constexpr size_t HUGE_PAGE_BYTES = 2 << 20;
+
+// Буферы от Threshold байт округляются вверх до целого числа страниц размера Page
+template <typename Base, size_t Page = PAGE_BYTES, size_t Threshold = Page * 16>
+struct PageRoundedGrowth {
+	static_assert(Page > 0);
+
+	static constexpr size_t NextCapacity(size_t capacity, size_t element_size) noexcept {
+		const size_t next = Base::NextCapacity(capacity, element_size);
+		const size_t bytes = next * element_size;
+		if (bytes < Threshold) {
+			return next;
+		}
+		return (bytes + Page - 1) / Page * Page / element_size;
+	}
+};
+
+using CacheLineGrowth = MinimumFirstAllocation<OneAndHalfGrowth, 1, CACHE_LINE_BYTES>;
+using PageGrowth = PageRoundedGrowth<CacheLineGrowth>;
+using HugePageGrowth = PageRoundedGrowth<CacheLineGrowth, HUGE_PAGE_BYTES, HUGE_PAGE_BYTES>;
+
+// Политика статистики Vector. NoVectorStats ничего не считает и не занимает места в объекте.
+struct NoVectorStats {
+	constexpr void OnAllocate(size_t /*capacity*/, size_t /*bytes*/) noexcept {
+	}
+	constexpr void OnExpand(size_t /*capacity*/) noexcept {
+	}
+	constexpr void OnReallocate() noexcept {
+	}
+	constexpr void OnRelocate(Relocation /*kind*/, size_t /*count*/) noexcept {
+	}
+};
+
+struct VectorStatsCounters {
+	size_t allocations = 0;
+	size_t allocated_bytes = 0;
+	size_t reallocations = 0;
+	size_t expansions = 0;
+	size_t relocated_bitwise = 0;
+	size_t relocated_by_move = 0;
+	size_t relocated_by_copy = 0;
+	size_t peak_capacity = 0;
+};
+
+// Статистика отдельного экземпляра, доступная через Vector::GetStats()
+class VectorStats {
+public:
+	constexpr void OnAllocate(size_t capacity, size_t bytes) noexcept {
+		++counters_.allocations;
+		counters_.allocated_bytes += bytes;
+		counters_.peak_capacity = std::max(counters_.peak_capacity, capacity);
+	}
+	constexpr void OnExpand(size_t capacity) noexcept {
+		++counters_.expansions;
+		counters_.peak_capacity = std::max(counters_.peak_capacity, capacity);
+	}
+	constexpr void OnReallocate() noexcept {
+		++counters_.reallocations;
+	}
+	constexpr void OnRelocate(Relocation kind, size_t count) noexcept {
+		switch (kind) {
+		case Relocation::BITWISE:
+			counters_.relocated_bitwise += count;
+			break;
+		case Relocation::MOVE:
+			counters_.relocated_by_move += count;
+			break;
+		case Relocation::COPY:
+			counters_.relocated_by_copy += count;
+			break;
+		}
+	}
+
+	constexpr const VectorStatsCounters& Get() const noexcept {
+		return counters_;
+	}
+
+private:
+	VectorStatsCounters counters_;
+};
+
+// Реестр счётчиков, общих для всех векторов с политикой GlobalVectorStats<Tag>
+class VectorStatsRegistry {
+public:
+	struct Entry {
+		explicit Entry(const char* name) noexcept
+			: name(name) {
+		}
+
+		VectorStatsCounters Snapshot() const noexcept {
+			VectorStatsCounters counters;
+			counters.allocations = allocations.load(std::memory_order_relaxed);
+			counters.allocated_bytes = allocated_bytes.load(std::memory_order_relaxed);
+			counters.reallocations = reallocations.load(std::memory_order_relaxed);
+			counters.expansions = expansions.load(std::memory_order_relaxed);
+			counters.relocated_bitwise = relocated_bitwise.load(std::memory_order_relaxed);
+			counters.relocated_by_move = relocated_by_move.load(std::memory_order_relaxed);
+			counters.relocated_by_copy = relocated_by_copy.load(std::memory_order_relaxed);
+			counters.peak_capacity = peak_capacity.load(std::memory_order_relaxed);
+			return counters;
+		}
+
+		const char* name;
+		std::atomic<size_t> allocations{ 0 };
+		std::atomic<size_t> allocated_bytes{ 0 };
+		std::atomic<size_t> reallocations{ 0 };
+		std::atomic<size_t> expansions{ 0 };
+		std::atomic<size_t> relocated_bitwise{ 0 };
+		std::atomic<size_t> relocated_by_move{ 0 };
+		std::atomic<size_t> relocated_by_copy{ 0 };
+		std::atomic<size_t> peak_capacity{ 0 };
+		Entry* next = nullptr;
+	};
+
+	static VectorStatsRegistry& Instance() {
+		static VectorStatsRegistry registry;
+		return registry;
+	}
+
+	void Register(Entry* entry) {
+		std::lock_guard guard(mutex_);
+		entry->next = head_;
+		head_ = entry;
+	}
+
+	// Вызывает visitor(name, counters) для каждой записи
+	template <typename Visitor>
+	void ForEach(Visitor visitor) const {
+		std::lock_guard guard(mutex_);
+		for (const Entry* entry = head_; entry != nullptr; entry = entry->next) {
+			visitor(entry->name, entry->Snapshot());
+		}
+	}
+
+private:
+	mutable std::mutex mutex_;
+	Entry* head_ = nullptr;
+};
+
+// Считает статистику экземпляра и суммарную статистику по тегу. Tag::NAME — имя записи в реестре.
+template <typename Tag>
+class GlobalVectorStats : public VectorStats {
+public:
+	void OnAllocate(size_t capacity, size_t bytes) noexcept {
+		VectorStats::OnAllocate(capacity, bytes);
+		Entry& entry = GetEntry();
+		entry.allocations.fetch_add(1, std::memory_order_relaxed);
+		entry.allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+		UpdatePeak(entry, capacity);
+	}
+	void OnExpand(size_t capacity) noexcept {
+		VectorStats::OnExpand(capacity);
+		GetEntry().expansions.fetch_add(1, std::memory_order_relaxed);
+		UpdatePeak(GetEntry(), capacity);
+	}
+	void OnReallocate() noexcept {
+		VectorStats::OnReallocate();
+		GetEntry().reallocations.fetch_add(1, std::memory_order_relaxed);
+	}
+	void OnRelocate(Relocation kind, size_t count) noexcept {
+		VectorStats::OnRelocate(kind, count);
+		Entry& entry = GetEntry();
+		switch (kind) {
+		case Relocation::BITWISE:
+			entry.relocated_bitwise.fetch_add(count, std::memory_order_relaxed);
+			break;
+		case Relocation::MOVE:
+			entry.relocated_by_move.fetch_add(count, std::memory_order_relaxed);
+			break;
+		case Relocation::COPY:
+			entry.relocated_by_copy.fetch_add(count, std::memory_order_relaxed);
+			break;
+		}
+	}
+
+	static VectorStatsCounters Total() noexcept {
+		return GetEntry().Snapshot();
+	}
+
+private:
+	using Entry = VectorStatsRegistry::Entry;
+
+	struct Registration {
+		Registration() {
+			VectorStatsRegistry::Instance().Register(&entry);
+		}
+		Entry entry{ Tag::NAME };
+	};
+
+	static Entry& GetEntry() noexcept {
+		static Registration registration;
+		return registration.entry;
+	}
+
+	static void UpdatePeak(Entry& entry, size_t capacity) noexcept {
+		size_t peak = entry.peak_capacity.load(std::memory_order_relaxed);
+		while (peak < capacity
+			&& !entry.peak_capacity.compare_exchange_weak(peak, capacity, std::memory_order_relaxed)) {
+		}
+	}
+};
+
+template <typename T, typename Alloc = std::allocator<T>, typename Growth = DoublingGrowth,
+	typename Stats = NoVectorStats>
+class Vector {
+	using AllocTraits = std::allocator_traits<Alloc>;
+
+public:
+	using iterator = T*;
+	using const_iterator = const T*;
+	using allocator_type = Alloc;
+
+	// Блок можно переносить через Reallocate аллокатора
+	static constexpr bool CAN_REALLOCATE = IsTriviallyRelocatableV<T>
+		&& detail::HasReallocate<Alloc, T>::value;
+
+	VECTOR_CONSTEXPR iterator begin() noexcept {
+		return data_.GetAddress();
+	}
+	VECTOR_CONSTEXPR iterator end() noexcept {
+		return data_.GetAddress() + size_;
+	}
+	VECTOR_CONSTEXPR const_iterator begin() const noexcept {
+		return data_.GetAddress();
+	}
+	VECTOR_CONSTEXPR const_iterator end() const noexcept {
+		return data_.GetAddress() + size_;
+
+	}
+	VECTOR_CONSTEXPR const_iterator cbegin() const noexcept {
+		return data_.GetAddress();
+	}
+	VECTOR_CONSTEXPR const_iterator cend() const noexcept {
+		return data_.GetAddress() + size_;
+	}
+	// Параметр site в конструкторах и методах, выделяющих память, — место вызова для профиля
+	// кучи (VECTOR_HEAP_PROFILE). Выделения в остальных методах, например в EmplaceBack,
+	// приписываются месту создания вектора.
+	VECTOR_CONSTEXPR Vector(detail::SourceSite site = detail::SourceSite::Current()) noexcept :
+		site_(site) {
+	}
+
+	VECTOR_CONSTEXPR explicit Vector(const Alloc& alloc, detail::SourceSite site = detail::SourceSite::Current()) noexcept :
+		data_(alloc), site_(site) {
+	}
+
+	VECTOR_CONSTEXPR explicit Vector(size_t size, const Alloc& alloc = Alloc(), detail::SourceSite site = detail::SourceSite::Current()) :
+		data_(AllocateAt(site, size, alloc)), size_(size), site_(site) {
+		detail::UninitializedValueConstructN(data_.GetAddress(), size_);
+		OnStorageAllocated();
+	}
+
+	// Элементы инициализируются по умолчанию: для тривиальных типов память не заполняется
+	Vector(size_t size, DefaultInitTag, const Alloc& alloc = Alloc(), detail::SourceSite site = detail::SourceSite::Current()) :
+		data_(AllocateAt(site, size, alloc)), size_(size), site_(site) {
+		std::uninitialized_default_construct_n(data_.GetAddress(), size_);
+		OnStorageAllocated();
+	}
+
+	VECTOR_CONSTEXPR Vector(const ParallelTag& policy, size_t size, const Alloc& alloc = Alloc(), detail::SourceSite site = detail::SourceSite::Current()) :
+		data_(AllocateAt(site, size, alloc)), size_(size), site_(site) {
+		detail::ParallelValueConstructN(policy, data_.GetAddress(), size_);
+		OnStorageAllocated();
+	}
+
+	VECTOR_CONSTEXPR Vector(const Vector& other, detail::SourceSite site = detail::SourceSite::Current()) :
+		Vector(other, AllocTraits::select_on_container_copy_construction(other.GetAllocator()), site) {
+	}
+
+	VECTOR_CONSTEXPR Vector(const Vector& other, const Alloc& alloc, detail::SourceSite site = detail::SourceSite::Current()) :
+		Vector(detail::SEQUENTIAL, other, alloc, site) {
+	}
+
+	VECTOR_CONSTEXPR Vector(const ParallelTag& policy, const Vector& other, detail::SourceSite site = detail::SourceSite::Current()) :
+		Vector(policy, other, AllocTraits::select_on_container_copy_construction(other.GetAllocator()), site) {
+	}
+
+	VECTOR_CONSTEXPR Vector(const ParallelTag& policy, const Vector& other, const Alloc& alloc,
+		detail::SourceSite site = detail::SourceSite::Current()) :
+		data_(AllocateAt(site, other.size_, alloc)), size_(other.size_), site_(site) {
+		detail::ParallelCopyN(policy, other.data_.GetAddress(), size_, data_.GetAddress());
+		OnStorageAllocated();
+	}
+
+	VECTOR_CONSTEXPR Vector(Vector&& other) noexcept :
+		data_(std::move(other.data_)), size_(std::exchange(other.size_, 0)), site_(other.site_) {
+	}
+
+	VECTOR_CONSTEXPR Vector& operator=(const Vector& rhs) {
+		return CopyFrom(detail::SEQUENTIAL, rhs);
+	}
+
+	// Копирующее присваивание, выполняемое в нескольких потоках
+	VECTOR_CONSTEXPR Vector& CopyFrom(const ParallelTag& policy, const Vector& rhs) {
+		if (this != &rhs) {
+			if constexpr (AllocTraits::propagate_on_container_copy_assignment::value
+				&& !AllocTraits::is_always_equal::value) {
+				if (GetAllocator() != rhs.GetAllocator()) {
+					// Память, выделенную нашим аллокатором, чужой аллокатор освободить не сможет
+					RawMemory<T, Alloc> new_data = AllocateStorage(rhs.size_, rhs.GetAllocator());
+					detail::ParallelCopyN(policy, rhs.data_.GetAddress(), rhs.size_, new_data.GetAddress());
+					ReplaceStorage(new_data, rhs.size_);
+					return *this;
+				}
+			}
+			if (rhs.size_ > data_.Capacity()) {
+				RawMemory<T, Alloc> new_data = AllocateStorage(rhs.size_);
+				detail::ParallelCopyN(policy, rhs.data_.GetAddress(), rhs.size_, new_data.GetAddress());
+				ReplaceStorage(new_data, rhs.size_);
+			}
+			else {
+				CopyLessVector(policy, rhs);
+			}
+		}
+		return *this;
+	}
+
+	VECTOR_CONSTEXPR Vector& operator=(Vector&& rhs) noexcept(AllocTraits::propagate_on_container_move_assignment::value
+		|| AllocTraits::is_always_equal::value) {
+		if (this != &rhs) {
+			if constexpr (!AllocTraits::propagate_on_container_move_assignment::value
+				&& !AllocTraits::is_always_equal::value) {
+				if (GetAllocator() != rhs.GetAllocator()) {
+					// Буфер забрать нельзя, поэтому перемещаем элементы по одному
+					RawMemory<T, Alloc> new_data = AllocateStorage(rhs.size_);
+					detail::UninitializedMoveN(rhs.begin(), rhs.size_, new_data.GetAddress());
+					ReplaceStorage(new_data, rhs.size_);
+					return *this;
+				}
+			}
+			SwapStorage(rhs);
+		}
+		return *this;
+	}
+
+	VECTOR_CONSTEXPR Alloc GetAllocator() const noexcept {
+		return data_.GetAllocator();
+	}
+
+	VECTOR_CONSTEXPR const Stats& GetStats() const noexcept {
+		return stats_;
+	}
+
+	VECTOR_CONSTEXPR size_t Size() const noexcept {
+		return size_;
+	}
+
+	VECTOR_CONSTEXPR size_t Capacity() const noexcept {
+		return data_.Capacity();
+	}
+
+	// Указатель на буфер с подсказкой компилятору о его выравнивании. По умолчанию
+	// используется выравнивание, которое гарантирует аллокатор (см. AlignedAllocator).
+	template <size_t Align = detail::AllocatorAlignment<Alloc>::value>
+	T* AssumeAligned() noexcept {
+		return detail::AssumeAligned<Align>(data_.GetAddress());
+	}
+
+	template <size_t Align = detail::AllocatorAlignment<Alloc>::value>
+	const T* AssumeAligned() const noexcept {
+		return detail::AssumeAligned<Align>(data_.GetAddress());
+	}
+
+	VECTOR_CONSTEXPR const T& operator[](size_t index) const noexcept {
+		return const_cast<Vector&>(*this)[index];
+	}
+
+	VECTOR_CONSTEXPR T& operator[](size_t index) noexcept {
+		assert(index < size_);
+		return data_[index];
+	}
+
+	VECTOR_CONSTEXPR ~Vector() {
+		detail::DestroyN(data_.GetAddress(), size_);
+	}
+
+	VECTOR_CONSTEXPR void Resize(size_t new_size, detail::SourceSite site = detail::SourceSite::Current()) {
+		detail::SiteScope scope(site);
+		Resize(detail::SEQUENTIAL, new_size);
+	}
+
+	// Строгая гарантия: если часть новых элементов не удалось создать, созданные
+	// в других потоках элементы разрушаются, а размер не меняется
+	VECTOR_CONSTEXPR void Resize(const ParallelTag& policy, size_t new_size) {
+		if (new_size < size_) {
+			detail::ParallelDestroyN(policy, data_.GetAddress() + new_size, size_ - new_size);
+		}
+		else if (new_size > size_) {
+			Reserve(new_size, site_);
+			detail::ParallelValueConstructN(policy, data_.GetAddress() + size_, new_size - size_);
+		}
+		else {
+			return;
+		}
+		size_ = new_size;
+	}
+
+	VECTOR_CONSTEXPR void Resize(size_t new_size, const T& value, detail::SourceSite site = detail::SourceSite::Current()) {
+		detail::SiteScope scope(site);
+		if (new_size > size_ && new_size > Capacity()
+			&& (detail::IsConstantEvaluated() || PointsIntoElements(&value))) {
+			// После реаллокации ссылка на элемент вектора станет недействительной. На этапе
+			// компиляции указатели на разные объекты сравнивать нельзя, поэтому копия делается всегда.
+			const T tmp(value);
+			Reserve(new_size);
+			Resize(new_size, tmp);
+			return;
+		}
+		if (new_size < size_) {
+			detail::DestroyN(data_.GetAddress() + new_size, size_ - new_size);
+		}
+		else if (new_size > size_) {
+			Reserve(new_size);
+			detail::UninitializedFillN(data_.GetAddress() + size_, new_size - size_, value);
+		}
+		size_ = new_size;
+	}
+
+	// Новые элементы инициализируются по умолчанию: для тривиальных типов память не заполняется
+	void ResizeDefaultInit(size_t new_size) {
+		if (new_size < size_) {
+			detail::DestroyN(data_.GetAddress() + new_size, size_ - new_size);
+		}
+		else if (new_size > size_) {
+			Reserve(new_size, site_);
+			std::uninitialized_default_construct_n(data_.GetAddress() + size_, new_size - size_);
+		}
+		size_ = new_size;
+	}
+
+	// Увеличивает размер до count без заполнения и передаёт буфер операции op(data, count),
+	// которая записывает элементы и возвращает итоговый размер (не больше count)
+	template <typename Operation>
+	void ResizeForOverwrite(size_t count, Operation op) {
+		ResizeDefaultInit(count);
+		const size_t new_size = std::move(op)(data_.GetAddress(), count);
+		assert(new_size <= count);
+		Resize(new_size);
+	}
+
+	template <typename... Args>
+	VECTOR_CONSTEXPR iterator Emplace(const_iterator pos, Args&&... args) {
+		assert(pos >= cbegin() && pos <= cend());
+		const size_t distance = pos - cbegin();
+		if (size_ == Capacity() && !TryExpand(NextCapacity())) {
+			if constexpr (CAN_REALLOCATE) {
+				return EmplaceRelocatable(distance, NextCapacity(), std::forward<Args>(args)...);
+			}
+			else {
+				RawMemory<T, Alloc> new_data = AllocateStorage(NextCapacity());
+				RelocateInto(new_data, distance, 1, [&](T* elem) {
+					detail::ConstructAt(elem, std::forward<Args>(args)...);
+				});
+			}
+		}
+		else if (distance == size_) {
+			detail::ConstructAt(data_ + size_, std::forward<Args>(args)...);
+			++size_;
+		}
+		else if constexpr (IsTriviallyRelocatableV<T>) {
+			if (!detail::IsConstantEvaluated()) {
+				return EmplaceRelocatable(distance, 0, std::forward<Args>(args)...);
+			}
+			// Элемент во временном буфере сырой памяти на этапе компиляции создать нельзя
+			T tmp(std::forward<Args>(args)...);
+			detail::RelocateOverlapping(data_ + distance, size_ - distance, data_ + distance + 1);
+			detail::ConstructAt(data_ + distance, std::move(tmp));
+			++size_;
+		}
+		else {
+			if constexpr (CanEmplaceWithoutTemporary<Args...>()) {
+				if (!detail::IsConstantEvaluated() && !(PointsIntoElements(std::addressof(args)) || ...)) {
+					ShiftTailRight(distance);
+					EmplaceShifted(distance, std::forward<Args>(args)...);
+					return data_ + distance;
+				}
+			}
+			T tmp(std::forward<Args>(args)...);
+			ShiftTailRight(distance);
+			data_[distance] = std::move(tmp);
+		}
+		return data_ + distance;
+	}
+
+
+	VECTOR_CONSTEXPR iterator Insert(const_iterator pos, const T& value) {
+		return Emplace(pos, value);
+	}
+
+	VECTOR_CONSTEXPR iterator Insert(const_iterator pos, T&& value) {
+		return Emplace(pos, std::move(value));
+	}
+
+	// Для forward-итераторов выполняет не более одной реаллокации и один сдвиг хвоста.
+	// Диапазон не должен указывать на элементы самого вектора, кроме вставки в конец.
+	template <typename InputIt, typename = detail::RequireInputIterator<InputIt>>
+	iterator Insert(const_iterator pos, InputIt first, InputIt last) {
+		assert(pos >= cbegin() && pos <= cend());
+		const size_t distance = pos - cbegin();
+		if constexpr (detail::IsForwardIteratorV<InputIt>) {
+			InsertForward(distance, first, last, static_cast<size_t>(std::distance(first, last)));
+		}
+		else {
+			const size_t old_size = size_;
+			try {
+				for (; first != last; ++first) {
+					EmplaceBack(*first);
+				}
+			}
+			catch (...) {
+				// Дописанные элементы удаляются: прежние элементы остаются на своих местах
+				detail::DestroyN(data_ + old_size, size_ - old_size);
+				size_ = old_size;
+				throw;
+			}
+			std::rotate(begin() + distance, begin() + old_size, end());
+		}
+		return begin() + distance;
+	}
+
+	iterator Insert(const_iterator pos, size_t count, const T& value) {
+		if (std::greater_equal<const T*>()(&value, cbegin()) && std::less<const T*>()(&value, cend())) {
+			const T tmp(value);
+			return Insert(pos, detail::RepeatIterator<T>(tmp, 0), detail::RepeatIterator<T>(tmp, count));
+		}
+		return Insert(pos, detail::RepeatIterator<T>(value, 0), detail::RepeatIterator<T>(value, count));
+	}
+
+	iterator Insert(const_iterator pos, std::initializer_list<T> ilist) {
+		return Insert(pos, ilist.begin(), ilist.end());
+	}
+
+	template <typename InputIt, typename = detail::RequireInputIterator<InputIt>>
+	void Append(InputIt first, InputIt last) {
+		Insert(cend(), first, last);
+	}
+
+	// Заменяет содержимое вектора элементами диапазона, переиспользуя имеющийся буфер
+	template <typename InputIt, typename = detail::RequireInputIterator<InputIt>>
+	void Assign(InputIt first, InputIt last) {
+		if constexpr (detail::IsForwardIteratorV<InputIt>) {
+			const size_t count = std::distance(first, last);
+			if (count > data_.Capacity()) {
+				RawMemory<T, Alloc> new_data = AllocateStorage(count);
+				std::uninitialized_copy(first, last, new_data.GetAddress());
+				ReplaceStorage(new_data, count);
+			}
+			else if (count <= size_) {
+				iterator new_end = std::copy(first, last, begin());
+				detail::DestroyN(new_end, size_ - count);
+				size_ = count;
+			}
+			else {
+				InputIt mid = std::next(first, size_);
+				std::copy(first, mid, begin());
+				std::uninitialized_copy(mid, last, end());
+				size_ = count;
+			}
+		}
+		else {
+			detail::DestroyN(data_.GetAddress(), std::exchange(size_, 0));
+			for (; first != last; ++first) {
+				EmplaceBack(*first);
+			}
+		}
+	}
+
+	template <typename... Args>
+	VECTOR_CONSTEXPR T& EmplaceBack(Args&&... args) {
+		return *Emplace(cend(), std::forward<Args>(args)...);
+	}
+
+	VECTOR_CONSTEXPR void PushBack(const T& value, detail::SourceSite site = detail::SourceSite::Current()) {
+		detail::SiteScope scope(site);
+		EmplaceBack(value);
+	}
+	VECTOR_CONSTEXPR void PushBack(T&& value, detail::SourceSite site = detail::SourceSite::Current()) {
+		detail::SiteScope scope(site);
+		EmplaceBack(std::move(value));
+	}
+
+	VECTOR_CONSTEXPR void PopBack() noexcept {
+		assert(size_ != 0);
+		std::destroy_at(data_.GetAddress() + size_ -1);
+		--size_;
+	}
+
+	VECTOR_CONSTEXPR void Reserve(size_t capacity, detail::SourceSite site = detail::SourceSite::Current()) {
+		detail::SiteScope scope(site);
+		if (capacity > data_.Capacity() && !TryExpand(capacity)) {
+			if constexpr (CAN_REALLOCATE) {
+				ReallocateStorage(capacity);
+			}
+			else {
+				RawMemory<T, Alloc> new_data = AllocateStorage(capacity);
+				RelocateInto(new_data, size_, 0, [](T*) noexcept {});
+			}
+		}
+	}
+
+	// Освобождает неиспользуемую вместимость. Предоставляет строгую гарантию безопасности исключений.
+	VECTOR_CONSTEXPR void ShrinkToFit() {
+		if (Capacity() == size_) {
+			return;
+		}
+		if (size_ == 0) {
+			RawMemory<T, Alloc> empty(data_.GetAllocator());
+			data_.Swap(empty);
+		}
+		else if constexpr (CAN_REALLOCATE) {
+			ReallocateStorage(size_);
+		}
+		else {
+			// allocate_at_least может вернуть блок с запасом, и тогда Capacity() больше размера
+			// и после ShrinkToFit. Если новый блок не меньше текущего, элементы не переносятся.
+			RawMemory<T, Alloc> new_data = AllocateAt(site_, size_, data_.GetAllocator());
+			if (new_data.Capacity() >= Capacity()) {
+				return;
+			}
+			stats_.OnAllocate(new_data.Capacity(), new_data.MemoryUsage());
+			RelocateInto(new_data, size_, 0, [](T*) noexcept {});
+		}
+	}
+
+	// Буфер, переданный вектору или полученный из него без копирования элементов
+	struct RawBuffer {
+		T* data = nullptr;
+		size_t size = 0;
+		size_t capacity = 0;
+	};
+
+	// Принимает во владение буфер, выделенный аллокатором, равным alloc, в котором
+	// сконструированы первые buffer.size элементов
+	static Vector FromRawBuffer(RawBuffer buffer, const Alloc& alloc = Alloc()) noexcept {
+		assert(buffer.size <= buffer.capacity);
+		Vector v(alloc);
+		RawMemory<T, Alloc> data = RawMemory<T, Alloc>::FromRawBuffer(buffer.data, buffer.capacity, alloc);
+		v.data_.Swap(data);
+		v.size_ = buffer.data != nullptr ? buffer.size : 0;
+		return v;
 	}
 
-	RawMemory(const RawMemory& other) = delete;
-	RawMemory& operator=(const RawMemory& other) = delete;
-	RawMemory(RawMemory&& other) noexcept {
-		Swap(other);
+	// Отдаёт буфер вместе с элементами, оставляя вектор пустым. Вызывающий отвечает
+	// за разрушение элементов и освобождение памяти через GetAllocator().
+	RawBuffer Release() noexcept {
+		const size_t capacity = data_.Capacity();
+		return { data_.Release(), std::exchange(size_, 0), capacity };
 	}
-	RawMemory& operator=(RawMemory&& other) noexcept {
-		if (this != &other) {
-			Swap(other);
+
+	// Байты буфера в куче, включая неиспользуемую вместимость
+	VECTOR_CONSTEXPR size_t MemoryUsage() const noexcept {
+		return data_.MemoryUsage();
+	}
+
+	// Байты буфера, не занятые элементами
+	VECTOR_CONSTEXPR size_t SlackBytes() const noexcept {
+		return data_.SlackBytes(size_);
+	}
+
+	VECTOR_CONSTEXPR void Swap(Vector& other) noexcept {
+		if constexpr (!AllocTraits::propagate_on_container_swap::value
+			&& !AllocTraits::is_always_equal::value) {
+			assert(GetAllocator() == other.GetAllocator());
 		}
-		return *this;
+		SwapStorage(other);
 	}
 
-	~RawMemory() {
-		Deallocate(buffer_);
+	VECTOR_CONSTEXPR iterator Erase(const_iterator pos) {
+		assert(pos >= cbegin() && pos <= cend());
+		size_t distance = std::distance(cbegin(),pos);
+		if constexpr (IsTriviallyRelocatableV<T>) {
+			std::destroy_at(data_.GetAddress() + distance);
+			detail::RelocateOverlapping(data_ + distance + 1, size_ - distance - 1, data_ + distance);
+		}
+		else {
+			std::move(begin() + distance + 1, end(), begin() + distance);
+			std::destroy_at(data_.GetAddress() + size_ - 1);
+		}
+		--size_;
+		return data_ + distance;
 	}
 
-	T* operator+(size_t offset) noexcept {
-		assert(offset <= capacity_);
-		return buffer_ + offset;
+	// Удаляет диапазон одним сдвигом хвоста
+	VECTOR_CONSTEXPR iterator Erase(const_iterator first, const_iterator last) {
+		assert(first >= cbegin() && first <= last && last <= cend());
+		const size_t distance = first - cbegin();
+		const size_t count = last - first;
+		if (count != 0) {
+			if constexpr (IsTriviallyRelocatableV<T>) {
+				detail::DestroyN(data_ + distance, count);
+				detail::RelocateOverlapping(data_ + distance + count, size_ - distance - count, data_ + distance);
+			}
+			else {
+				iterator new_end = std::move(begin() + distance + count, end(), begin() + distance);
+				detail::DestroyN(new_end, count);
+			}
+			size_ -= count;
+		}
+		return data_ + distance;
 	}
 
-	const T* operator+(size_t offset) const noexcept {
-		return const_cast<RawMemory&>(*this) + offset;
+	// Удаляет все элементы, сохраняя вместимость
+	VECTOR_CONSTEXPR void Clear() noexcept {
+		detail::DestroyN(data_.GetAddress(), size_);
+		size_ = 0;
 	}
 
-	const T& operator[](size_t index) const noexcept {
-		return const_cast<RawMemory&>(*this)[index];
+	// Деструктор разрушает элементы в одном потоке; для больших векторов его работу
+	// можно распараллелить, вызвав Clear(PARALLEL) заранее
+	VECTOR_CONSTEXPR void Clear(const ParallelTag& policy) noexcept {
+		detail::ParallelDestroyN(policy, data_.GetAddress(), size_);
+		size_ = 0;
 	}
 
-	T& operator[](size_t index) noexcept {
-		assert(index < capacity_);
-		return buffer_[index];
+	// Удаляет элементы, удовлетворяющие предикату, за один проход: каждый оставшийся элемент
+	// перемещается не более одного раза. Возвращает количество удалённых элементов.
+	template <typename Predicate>
+	size_t EraseIf(Predicate pred) {
+		const size_t old_size = size_;
+		if constexpr (IsTriviallyRelocatableV<T>) {
+			T* out = begin();
+			T* it = begin();
+			try {
+				for (; it != end(); ++it) {
+					if (pred(*it)) {
+						std::destroy_at(it);
+					}
+					else {
+						if (out != it) {
+							detail::RelocateOverlapping(it, 1, out);
+						}
+						++out;
+					}
+				}
+			}
+			catch (...) {
+				// Непроверенный остаток подтягивается к уже уплотнённой части
+				detail::RelocateOverlapping(it, end() - it, out);
+				size_ = (out - begin()) + (end() - it);
+				throw;
+			}
+			size_ = out - begin();
+		}
+		else {
+			Erase(std::remove_if(begin(), end(), pred), cend());
+		}
+		return old_size - size_;
 	}
 
-	void Swap(RawMemory& other) noexcept {
-		std::swap(buffer_, other.buffer_);
-		std::swap(capacity_, other.capacity_);
+private:
+	RawMemory<T, Alloc> data_;
+	size_t size_ = 0;
+	[[no_unique_address]] Stats stats_;
+	[[no_unique_address]] detail::SourceSite site_;
+
+	// Статистика остаётся у экземпляра: обмениваются только буфер и размер
+	VECTOR_CONSTEXPR void SwapStorage(Vector& other) noexcept {
+		data_.Swap(other.data_);
+		std::swap(size_, other.size_);
 	}
 
-	const T* GetAddress() const noexcept {
-		return buffer_;
+	VECTOR_CONSTEXPR RawMemory<T, Alloc> AllocateStorage(size_t capacity) {
+		return AllocateStorage(capacity, data_.GetAllocator());
 	}
 
-	T* GetAddress() noexcept {
-		return buffer_;
+	static VECTOR_CONSTEXPR RawMemory<T, Alloc> AllocateAt(detail::SourceSite site, size_t capacity, const Alloc& alloc) {
+		detail::SiteScope scope(site);
+		return RawMemory<T, Alloc>(capacity, alloc);
 	}
 
-	size_t Capacity() const {
-		return capacity_;
+	VECTOR_CONSTEXPR RawMemory<T, Alloc> AllocateStorage(size_t capacity, const Alloc& alloc) {
+		RawMemory<T, Alloc> memory = AllocateAt(site_, capacity, alloc);
+		if (memory.Capacity() != 0) {
+			stats_.OnAllocate(memory.Capacity(), memory.MemoryUsage());
+		}
+		return memory;
 	}
 
-private:
-	static T* Allocate(size_t n) {
-		return n != 0 ? static_cast<T*>(operator new(n * sizeof(T))) : nullptr;
+	VECTOR_CONSTEXPR void OnStorageAllocated() noexcept {
+		if (Capacity() != 0) {
+			stats_.OnAllocate(Capacity(), MemoryUsage());
+		}
 	}
 
-	static void Deallocate(T* buf) noexcept {
-		operator delete(buf);
+	// Заменяет буфер на new_data, в который уже перенесены все элементы
+	VECTOR_CONSTEXPR void AdoptRelocated(RawMemory<T, Alloc>& new_data) noexcept {
+		if (data_.Capacity() != 0) {
+			stats_.OnReallocate();
+			detail::ProfileReallocate(new_data.GetAddress());
+		}
+		detail::DestroyRelocated(data_.GetAddress(), size_);
+		data_.Swap(new_data);
 	}
 
-	T* buffer_ = nullptr;
-	size_t capacity_ = 0;
+	// Разрушает элементы и заменяет буфер на new_data с new_size новыми элементами
+	VECTOR_CONSTEXPR void ReplaceStorage(RawMemory<T, Alloc>& new_data, size_t new_size) noexcept {
+		detail::DestroyN(data_.GetAddress(), size_);
+		data_.Swap(new_data);
+		size_ = new_size;
+	}
+
+	VECTOR_CONSTEXPR bool TryExpand(size_t capacity) noexcept {
+		if (data_.TryExpand(capacity)) {
+			stats_.OnExpand(capacity);
+			return true;
+		}
+		return false;
+	}
+
+	VECTOR_CONSTEXPR void ReallocateStorage(size_t capacity) {
+		const bool had_storage = data_.Capacity() != 0;
+		{
+			detail::SiteScope scope(site_);
+			data_.Reallocate(capacity);
+		}
+		stats_.OnAllocate(capacity, MemoryUsage());
+		if (had_storage) {
+			stats_.OnRelocate(Relocation::BITWISE, size_);
+			stats_.OnReallocate();
+			detail::ProfileReallocate(data_.GetAddress());
+		}
+	}
+
+	VECTOR_CONSTEXPR void CopyLessVector(const ParallelTag& policy, const Vector& other) {
+		const T* from = other.data_.GetAddress();
+		T* to = data_.GetAddress();
+		if (detail::IsConstantEvaluated()) {
+			std::copy_n(from, std::min(other.size_, size_), to);
+		}
+		else {
+			detail::ParallelChunks(policy, std::min(other.size_, size_),
+				[from, to](size_t first, size_t last) { std::copy(from + first, from + last, to + first); },
+				[](size_t /*first*/, size_t /*last*/) noexcept {});
+		}
+		if (other.size_ <= size_) {
+			detail::ParallelDestroyN(policy, to + other.size_, size_ - other.size_);
+		}
+		else {
+			detail::ParallelCopyN(policy, from + size_, other.size_ - size_, to + size_);
+		}
+		size_ = other.size_;
+	}
+
+	template <typename ForwardIt>
+	void InsertForward(size_t distance, ForwardIt first, ForwardIt last, size_t count) {
+		if (count == 0) {
+			return;
+		}
+		if (size_ + count > Capacity() && !TryExpand(size_ + count)) {
+			// Сначала копируется диапазон: до переноса старые элементы остаются нетронутыми
+			RawMemory<T, Alloc> new_data = AllocateStorage(std::max(NextCapacity(), size_ + count));
+			RelocateInto(new_data, distance, count, [&first, &last](T* inserted) {
+				std::uninitialized_copy(first, last, inserted);
+			});
+			return;
+		}
+
+		T* pos = data_ + distance;
+		T* old_end = end();
+		const size_t tail = size_ - distance;
+		if constexpr (IsTriviallyRelocatableV<T>) {
+			detail::RelocateOverlapping(pos, tail, pos + count);
+			try {
+				std::uninitialized_copy(first, last, pos);
+			}
+			catch (...) {
+				detail::RelocateOverlapping(pos + count, tail, pos);
+				throw;
+			}
+			size_ += count;
+		}
+		else if constexpr (std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>) {
+			// Диапазон копируется в свободную память за концом до того, как сдвигается хвост:
+			// если копирование выбросит исключение, вектор не изменится. Поворот не бросает.
+			std::uninitialized_copy(first, last, old_end);
+			size_ += count;
+			std::rotate(pos, old_end, old_end + count);
+		}
+		else if (tail > count) {
+			std::uninitialized_move(old_end - count, old_end, old_end);
+			size_ += count;
+			std::move_backward(pos, old_end - count, old_end);
+			std::copy(first, last, pos);
+		}
+		else {
+			ForwardIt mid = std::next(first, tail);
+			std::uninitialized_copy(mid, last, old_end);
+			size_ += count - tail;
+			std::uninitialized_move(pos, old_end, pos + count);
+			size_ += tail;
+			std::copy(first, mid, pos);
+		}
+	}
+
+	// Временный объект не нужен, если аргументы не ссылаются на элементы вектора, а значение
+	// можно записать на место сдвинутого элемента без риска потерять его: присваиванием noexcept
+	// единственного аргумента типа T или конструктором noexcept из скалярных аргументов.
+	// Бросающее присваивание после сдвига оставило бы в векторе перемещённый элемент.
+	template <typename... Args>
+	static constexpr bool CanEmplaceWithoutTemporary() noexcept {
+		if constexpr (sizeof...(Args) == 1 && (std::is_same_v<std::decay_t<Args>, T> && ...)) {
+			return (std::is_nothrow_assignable_v<T&, Args&&> && ...);
+		}
+		else {
+			return std::is_nothrow_constructible_v<T, Args&&...>
+				&& ((std::is_arithmetic_v<std::decay_t<Args>> || std::is_enum_v<std::decay_t<Args>>) && ...);
+		}
+	}
+
+	template <typename U>
+	bool PointsIntoElements(const U* ptr) const noexcept {
+		const void* address = ptr;
+		return std::greater_equal<const void*>()(address, cbegin()) && std::less<const void*>()(address, cend());
+	}
+
+	// Освобождает позицию distance: её элемент остаётся в состоянии после перемещения
+	VECTOR_CONSTEXPR void ShiftTailRight(size_t distance) {
+		detail::ConstructAt(data_ + size_, std::move(data_[size_ - 1]));
+		// Новый последний элемент уже сконструирован: при исключении ниже вектор остаётся целым
+		++size_;
+		std::move_backward(begin() + distance, end() - 2, end() - 1);
+	}
+
+	template <typename... Args>
+	VECTOR_CONSTEXPR void EmplaceShifted(size_t distance, Args&&... args) {
+		if constexpr (sizeof...(Args) == 1 && (std::is_same_v<std::decay_t<Args>, T> && ...)) {
+			data_[distance] = (std::forward<Args>(args), ...);
+		}
+		else {
+			std::destroy_at(data_ + distance);
+			detail::ConstructAt(data_ + distance, std::forward<Args>(args)...);
+		}
+	}
+
+	VECTOR_CONSTEXPR size_t NextCapacity() const noexcept {
+		const size_t capacity = Growth::NextCapacity(data_.Capacity(), sizeof(T));
+		assert(capacity > size_);
+		return capacity;
+	}
+
+	// Элемент конструируется во временном буфере до возможного переезда блока,
+	// так как аргументы могут ссылаться на элементы самого вектора
+	template <typename... Args>
+	iterator EmplaceRelocatable(size_t distance, size_t new_capacity, Args&&... args) {
+		alignas(T) unsigned char tmp[sizeof(T)];
+		T* elem = new(tmp) T(std::forward<Args>(args)...);
+		if constexpr (CAN_REALLOCATE) {
+			if (new_capacity != 0) {
+				try {
+					ReallocateStorage(new_capacity);
+				}
+				catch (...) {
+					std::destroy_at(elem);
+					throw;
+				}
+			}
+		}
+		detail::RelocateOverlapping(data_ + distance, size_ - distance, data_ + distance + 1);
+		detail::RelocateOverlapping(elem, 1, data_ + distance);
+		++size_;
+		return data_ + distance;
+	}
+
+	// Все реаллокации с переносом элементов проходят здесь (см. detail::RelocateInto):
+	// при исключении вектор не меняется, а new_data освобождается вызывающим
+	template <typename Construct>
+	VECTOR_CONSTEXPR void RelocateInto(RawMemory<T, Alloc>& new_data, size_t distance, size_t gap, Construct&& construct) {
+		detail::RelocateInto(data_.GetAddress(), size_, new_data.GetAddress(), distance, gap,
+			std::forward<Construct>(construct));
+		stats_.OnRelocate(detail::RelocationOf<T>(), size_);
+		AdoptRelocated(new_data);
+		size_ += gap;
+	}
 };
 
-template <typename T>
-class Vector {
+// Вектор для коротко живущих объектов: буферы переиспользуются через BufferCache потока
+template <typename T, typename Growth = DoublingGrowth>
+using RecyclingVector = Vector<T, RecyclingAllocator<T>, Growth>;
+
+// Копирует первые N элементов в std::array. Вектор, построенный в константном выражении,
+// не может пережить его вычисление, а массив может и попадает в секцию данных только для чтения:
+//   constexpr auto TABLE = ToArray<BuildTable().Size()>(BuildTable());
+template <size_t N, typename T, typename Alloc, typename Growth, typename Stats>
+VECTOR_CONSTEXPR std::array<T, N> ToArray(const Vector<T, Alloc, Growth, Stats>& v) {
+	assert(v.Size() >= N);
+	std::array<T, N> result{};
+	std::copy_n(v.begin(), N, result.begin());
+	return result;
+}
+
+// Вектор, хранящий до N элементов во встроенном буфере. Память в куче выделяется только
+// когда элементы перестают помещаться во встроенный буфер.
+template <typename T, size_t N, typename Growth = DoublingGrowth>
+class SmallVector {
+	static_assert(N > 0);
+
 public:
 	using iterator = T*;
 	using const_iterator = const T*;
 
 	iterator begin() noexcept {
-		return data_.GetAddress();
+		return Data();
 	}
 	iterator end() noexcept {
-		return data_.GetAddress() + size_;
+		return Data() + size_;
 	}
 	const_iterator begin() const noexcept {
-		return data_.GetAddress();
+		return Data();
 	}
 	const_iterator end() const noexcept {
-		return data_.GetAddress() + size_;
-
+		return Data() + size_;
 	}
 	const_iterator cbegin() const noexcept {
-		return data_.GetAddress();
+		return Data();
 	}
 	const_iterator cend() const noexcept {
-		return data_.GetAddress() + size_;
+		return Data() + size_;
+	}
+
+	SmallVector() noexcept {
 	}
-	Vector() = default;
 
-	explicit Vector(size_t size) :
-		data_(size), size_(size) {
-		std::uninitialized_value_construct_n(data_.GetAddress(), size_);
+	explicit SmallVector(size_t size) {
+		Reserve(size);
+		std::uninitialized_value_construct_n(Data(), size);
+		size_ = size;
 	}
 
-	Vector(const Vector& other) :
-		data_(other.size_), size_(other.size_) {
-		std::uninitialized_copy_n(other.data_.GetAddress(), size_, data_.GetAddress());
+	SmallVector(const SmallVector& other) {
+		Reserve(other.size_);
+		std::uninitialized_copy_n(other.Data(), other.size_, Data());
+		size_ = other.size_;
 	}
 
-	Vector(Vector&& other) noexcept {
-		Swap(other);
+	// Элементы из встроенного буфера переносятся, буфер в куче забирается целиком
+	SmallVector(SmallVector&& other) noexcept(NOTHROW_RELOCATE) :
+		heap_(std::move(other.heap_)) {
+		if (!IsHeap()) {
+			detail::UninitializedRelocate(other.InlineData(), other.size_, InlineData());
+			detail::DestroyRelocated(other.InlineData(), other.size_);
+		}
+		size_ = std::exchange(other.size_, 0);
 	}
 
-	Vector& operator=(const Vector& rhs) {
+	SmallVector& operator=(const SmallVector& rhs) {
 		if (this != &rhs) {
-			if (rhs.size_ > data_.Capacity()) {
-				Vector tmp(rhs);
-				Swap(tmp);
+			if (rhs.size_ > Capacity()) {
+				SmallVector tmp(rhs);
+				*this = std::move(tmp);
 			}
 			else {
-				CopyLessVector(rhs);
+				std::copy(rhs.begin(), rhs.begin() + std::min(rhs.size_, size_), begin());
+				if (rhs.size_ <= size_) {
+					detail::DestroyN(Data() + rhs.size_, size_ - rhs.size_);
+				}
+				else {
+					std::uninitialized_copy_n(rhs.Data() + size_, rhs.size_ - size_, Data() + size_);
+				}
+				size_ = rhs.size_;
 			}
 		}
 		return *this;
 	}
 
-	Vector& operator=(Vector&& rhs) noexcept {
+	SmallVector& operator=(SmallVector&& rhs) noexcept(NOTHROW_RELOCATE) {
 		if (this != &rhs) {
-			Swap(rhs);
+			detail::DestroyN(Data(), std::exchange(size_, 0));
+			if (rhs.IsHeap()) {
+				RawMemory<T> stolen(std::move(rhs.heap_));
+				heap_.Swap(stolen);
+			}
+			else {
+				detail::UninitializedRelocate(rhs.InlineData(), rhs.size_, Data());
+				detail::DestroyRelocated(rhs.InlineData(), rhs.size_);
+			}
+			size_ = std::exchange(rhs.size_, 0);
 		}
 		return *this;
 	}
 
+	~SmallVector() {
+		detail::DestroyN(Data(), size_);
+	}
+
 	size_t Size() const noexcept {
 		return size_;
 	}
 
 	size_t Capacity() const noexcept {
-		return data_.Capacity();
+		return IsHeap() ? heap_.Capacity() : N;
+	}
+
+	// Элементы лежат во встроенном буфере
+	bool IsInline() const noexcept {
+		return !IsHeap();
 	}
 
 	const T& operator[](size_t index) const noexcept {
-		return const_cast<Vector&>(*this)[index];
+		return const_cast<SmallVector&>(*this)[index];
 	}
 
 	T& operator[](size_t index) noexcept {
 		assert(index < size_);
-		return data_[index];
+		return Data()[index];
 	}
 
-	~Vector() {
-		std::destroy_n(data_.GetAddress(), size_);
+	void Reserve(size_t capacity) {
+		if (capacity > Capacity()) {
+			RawMemory<T> new_data(capacity);
+			RelocateInto(new_data, size_, 0, [](T*) noexcept {});
+		}
 	}
 
 	void Resize(size_t new_size) {
 		if (new_size < size_) {
-			std::destroy_n(data_.GetAddress() + new_size, size_ - new_size);
+			detail::DestroyN(Data() + new_size, size_ - new_size);
 		}
 		else if (new_size > size_) {
 			Reserve(new_size);
-			std::uninitialized_value_construct_n(data_.GetAddress() + size_, new_size - size_);
-		}
-		else {
-			return;
+			std::uninitialized_value_construct_n(Data() + size_, new_size - size_);
 		}
 		size_ = new_size;
 	}
 
+	template <typename... Args>
+	T& EmplaceBack(Args&&... args) {
+		return *Emplace(cend(), std::forward<Args>(args)...);
+	}
+
+	void PushBack(const T& value) {
+		EmplaceBack(value);
+	}
+	void PushBack(T&& value) {
+		EmplaceBack(std::move(value));
+	}
+
+	void PopBack() noexcept {
+		assert(size_ != 0);
+		std::destroy_at(Data() + size_ - 1);
+		--size_;
+	}
+
 	template <typename... Args>
 	iterator Emplace(const_iterator pos, Args&&... args) {
 		assert(pos >= cbegin() && pos <= cend());
-		size_t distance = std::distance(cbegin(), pos);
+		const size_t distance = pos - cbegin();
 		if (size_ == Capacity()) {
-			size_t new_capacity;
-			size_ == 0 ? new_capacity = 1 : new_capacity = size_ * 2;
-			RawMemory<T> new_data(new_capacity);
-			new(new_data + distance) T(std::forward<Args>(args)...);
-			try {
-				InitializedNewData(begin(), begin() + distance, new_data.GetAddress()); 
-			}
-			catch (...) {
-				std::destroy_at(new_data.GetAddress() + distance);
-				throw;
-			}
-			try {
-				InitializedNewData(begin() + distance, end(), new_data.GetAddress() + distance + 1);
-			}
-			catch (...) {
-				std::destroy_n(new_data.GetAddress(), distance);
-				throw;
-			}
-			std::destroy_n(data_.GetAddress(), size_);
-			data_.Swap(new_data);
+			RawMemory<T> new_data(Growth::NextCapacity(Capacity(), sizeof(T)));
+			RelocateInto(new_data, distance, 1, [&](T* elem) {
+				new(elem) T(std::forward<Args>(args)...);
+			});
+			return Data() + distance;
+		}
+		else if (distance == size_) {
+			new(Data() + size_) T(std::forward<Args>(args)...);
+		}
+		else if constexpr (IsTriviallyRelocatableV<T>) {
+			alignas(T) unsigned char tmp[sizeof(T)];
+			T* elem = new(tmp) T(std::forward<Args>(args)...);
+			detail::RelocateOverlapping(Data() + distance, size_ - distance, Data() + distance + 1);
+			detail::RelocateOverlapping(elem, 1, Data() + distance);
 		}
 		else {
-			if (size_ != 0) {
-				T tmp(std::forward<Args>(args)...);
-				try {
-					new(data_ + size_) T(std::forward<T>(*(data_.GetAddress() + size_ - 1)));
-					std::move_backward(begin() + distance, end() - 1, data_ + size_);
-					*(data_.GetAddress() + distance) = std::move(tmp);
-				}
-				catch (...) {
-					std::destroy_at(data_.GetAddress() + size_ + 1);
-					throw;
-				}
-			}
-			else {
-				new(data_ + distance) T(std::forward<Args>(args)...);
-			}
+			T tmp(std::forward<Args>(args)...);
+			new(Data() + size_) T(std::move(Data()[size_ - 1]));
+			// Новый последний элемент уже сконструирован: при исключении ниже вектор остаётся целым
+			++size_;
+			std::move_backward(Data() + distance, Data() + size_ - 2, Data() + size_ - 1);
+			Data()[distance] = std::move(tmp);
+			return Data() + distance;
 		}
 		++size_;
-		return data_ + distance;
+		return Data() + distance;
 	}
 
-
 	iterator Insert(const_iterator pos, const T& value) {
 		return Emplace(pos, value);
 	}
@@ -232,87 +2297,71 @@ public:
 	iterator Insert(const_iterator pos, T&& value) {
 		return Emplace(pos, std::move(value));
 	}
-	template <typename... Args>
-	T& EmplaceBack(Args&&... args) {
-		if (size_ == Capacity()) {
-			size_t new_capacity;
-			size_ == 0 ? new_capacity = 1 : new_capacity = size_ * 2;
-			RawMemory<T> new_data(new_capacity);
-			new(new_data + size_) T(std::forward<Args>(args)...);
-			try {
-				InitializedNewData(begin(), begin() + size_, new_data.GetAddress());
-			}
-			catch (...) {
-				std::destroy_at(new_data.GetAddress() + size_);
-			}
-			std::destroy_n(data_.GetAddress(), size_);
-			data_.Swap(new_data);
+
+	iterator Erase(const_iterator pos) {
+		assert(pos >= cbegin() && pos < cend());
+		const size_t distance = pos - cbegin();
+		if constexpr (IsTriviallyRelocatableV<T>) {
+			std::destroy_at(Data() + distance);
+			detail::RelocateOverlapping(Data() + distance + 1, size_ - distance - 1, Data() + distance);
 		}
 		else {
-			new(data_ + size_) T(std::forward<Args>(args)...);
+			std::move(Data() + distance + 1, end(), Data() + distance);
+			std::destroy_at(Data() + size_ - 1);
 		}
-		++size_;
-		return *(data_ + size_ - 1);
-	}
-
-	void PushBack(const T& value) {
-		EmplaceBack(value);
-	}
-	void PushBack(T&& value) {
-		EmplaceBack(std::move(value));
-	}
-
-	void PopBack() noexcept {
-		assert(size_ != 0);
-		std::destroy_at(data_.GetAddress() + size_ -1);
 		--size_;
+		return Data() + distance;
 	}
 
-	void Reserve(size_t capacity) {
-		if (capacity > data_.Capacity()) {
-			RawMemory<T> new_data(capacity);
-			InitializedNewData(data_.GetAddress(), data_.GetAddress() + size_, new_data.GetAddress());
-			std::destroy_n(data_.GetAddress(), size_);
-			data_.Swap(new_data);
+	void Swap(SmallVector& other) noexcept(NOTHROW_RELOCATE) {
+		if (IsHeap() && other.IsHeap()) {
+			heap_.Swap(other.heap_);
+			std::swap(size_, other.size_);
+		}
+		else {
+			SmallVector tmp(std::move(other));
+			other = std::move(*this);
+			*this = std::move(tmp);
 		}
 	}
 
-	void Swap(Vector& other) noexcept {
-		data_.Swap(other.data_);
-		std::swap(size_, other.size_);
+private:
+	static constexpr bool NOTHROW_RELOCATE = IsTriviallyRelocatableV<T>
+		|| std::is_nothrow_move_constructible_v<T>;
+
+	bool IsHeap() const noexcept {
+		return heap_.Capacity() != 0;
 	}
 
-	iterator Erase(const_iterator pos) {
-		assert(pos >= cbegin() && pos <= cend());
-		size_t distance = std::distance(cbegin(),pos);
-		std::move(begin() + distance + 1, end(), begin() + distance);
-		std::destroy_at(data_.GetAddress() + size_ - 1);
-		--size_;
-		return data_ + distance;
+	template <typename Construct>
+	void RelocateInto(RawMemory<T>& new_data, size_t distance, size_t gap, Construct&& construct) {
+		detail::RelocateInto(Data(), size_, new_data.GetAddress(), distance, gap, std::forward<Construct>(construct));
+		detail::DestroyRelocated(Data(), size_);
+		heap_.Swap(new_data);
+		size_ += gap;
 	}
 
-private:
-	RawMemory<T> data_;
-	size_t size_ = 0;
+	T* InlineData() noexcept {
+		return reinterpret_cast<T*>(inline_);
+	}
 
-	void CopyLessVector(const Vector& other) {
-		std::copy(other.begin(), other.begin() + std::min(other.size_, size_), begin());
-		if (other.size_ <= size_) {
-			std::destroy_n(data_.GetAddress() + other.size_, size_ - other.size_);
-		}
-		else {
-			std::uninitialized_copy_n(other.data_.GetAddress() + size_, other.size_ - size_, data_.GetAddress() + size_);
-		}
-		size_ = other.size_;
+	const T* InlineData() const noexcept {
+		return reinterpret_cast<const T*>(inline_);
 	}
 
-	void InitializedNewData(iterator first, iterator last, iterator d_first) {
-		if constexpr (!std::is_copy_constructible_v<T> || std::is_nothrow_move_constructible_v<T>) {
-			std::uninitialized_move(first, last, d_first);
+	T* Data() noexcept {
+		return IsHeap() ? heap_.GetAddress() : InlineData();
+	}
 
-		}
-		else {
-			std::uninitialized_copy(first, last, d_first);
-		}
+	const T* Data() const noexcept {
+		return IsHeap() ? heap_.GetAddress() : InlineData();
 	}
+
+	alignas(T) unsigned char inline_[N * sizeof(T)];
+	RawMemory<T> heap_;
+	size_t size_ = 0;
 };
+
+#ifdef VECTOR_HEAP_PROFILE
+#include "heap_profile.h"
+#endif